@@ -0,0 +1,311 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../Common/output.h"
+
+// A small harness for the stage benchmarks. Each benchmark program
+// includes this header in its only translation unit, since it replaces
+// the global operator new to count allocations.
+//
+// Every measurement runs in a forked child that generates its own input,
+// so the peak RSS reported is that of one scan, as in a real stage run.
+//
+// A baseline is a tab-separated file with one header line and one row per
+// (stage, shape, bytes); --save merges the current rows into it and
+// --compare reports the change against it, failing on a regression.
+
+inline std::atomic<uint64_t> allocationCount{0};
+
+// Not inlined, so the compiler does not mistake malloc and free for
+// mismatched calls of new and delete
+[[gnu::noinline]] void *operator new(std::size_t n) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(n ? n : 1))  return p;
+    throw std::bad_alloc();
+}
+[[gnu::noinline]] void *operator new[](std::size_t n) { return operator new(n); }
+[[gnu::noinline]] void operator delete(void *p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void *p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+struct BenchResult {
+    std::string stage;
+    std::string shape;
+    uint64_t bytes = 0;
+    uint64_t tokens = 0;
+    double seconds = 0;         // best of the timed runs
+    uint64_t allocations = 0;   // during the first run
+    uint64_t peakRssKb = 0;
+
+    double mbPerSec() const { return bytes / seconds / 1e6; }
+    double tokensPerSec() const { return tokens / seconds; }
+    double allocsPerToken() const { return tokens ? double(allocations) / tokens : 0; }
+};
+
+struct BenchOptions {
+    double megabytes = 1;
+    unsigned runs = 3;
+    std::string shape;          // empty means every shape
+    std::string savePath;
+    std::string comparePath;
+    double tolerance = 10;      // percent
+};
+
+// return value as a non-negative number; strtod would also accept a
+// sign, leading spaces, "inf" and "nan"
+inline double parseBenchNumber(const std::string &option, const char *value) {
+    char *end;
+    errno = 0;
+    double d = std::strtod(value, &end);
+    if (!(std::isdigit(static_cast<unsigned char>(*value)) || *value == '.') || *end != '\0' ||
+        errno == ERANGE || !std::isfinite(d)) {
+        throw std::runtime_error ("Invalid value for " + option + ": " + value);
+    }
+    return d;
+}
+
+// return value as a count that fits in an unsigned
+inline unsigned parseBenchCount(const std::string &option, const char *value) {
+    char *end;
+    errno = 0;
+    unsigned long n = std::strtoul(value, &end, 10);
+    if (!std::isdigit(static_cast<unsigned char>(*value)) || *end != '\0' || errno == ERANGE || n > UINT_MAX) {
+        throw std::runtime_error ("Invalid value for " + option + ": " + value);
+    }
+    return n;
+}
+
+// Usage: <bench> [--size MB] [--runs N] [--shape name] [--save file]
+//                [--compare file] [--tolerance percent]
+inline BenchOptions parseBenchOptions(int argc, char *argv[]) {
+    BenchOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 == argc)  throw std::runtime_error ("Missing value for " + arg);
+        const char *value = argv[++i];
+        if (arg == "--size")  opts.megabytes = parseBenchNumber(arg, value);
+        else if (arg == "--runs")  opts.runs = parseBenchCount(arg, value);
+        else if (arg == "--shape")  opts.shape = value;
+        else if (arg == "--save")  opts.savePath = value;
+        else if (arg == "--compare")  opts.comparePath = value;
+        else if (arg == "--tolerance")  opts.tolerance = parseBenchNumber(arg, value);
+        else throw std::runtime_error ("Unknown option " + arg);
+    }
+    if (opts.megabytes <= 0 || opts.runs == 0)  throw std::runtime_error ("Invalid --size or --runs");
+    return opts;
+}
+
+// The numbers a child sends back to its parent
+struct ChildReport {
+    int failed;
+    uint64_t bytes;
+    uint64_t tokens;
+    uint64_t allocations;
+    double seconds;
+};
+
+// Run scan over generate() runs times in a forked child. scan returns the
+// number of tokens it produced.
+inline BenchResult measure(const std::string &stage, const std::string &shape, const unsigned runs,
+                           const std::function<std::string()> &generate,
+                           const std::function<size_t(std::string_view)> &scan) {
+    int fds[2];
+    if (pipe(fds) != 0)  throw std::runtime_error ("pipe failed");
+    out.flush();
+    pid_t pid = fork();
+    if (pid < 0)  throw std::runtime_error ("fork failed");
+    if (pid == 0) {
+        close(fds[0]);
+        ChildReport report{};
+        try {
+            std::string input = generate();
+            report.bytes = input.size();
+            for (unsigned r = 0; r < runs; ++r) {
+                uint64_t before = allocationCount.load();
+                auto start = std::chrono::steady_clock::now();
+                size_t tokens = scan(input);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                if (r == 0) {
+                    report.allocations = allocationCount.load() - before;
+                    report.tokens = tokens;
+                    report.seconds = elapsed.count();
+                }
+                report.seconds = std::min(report.seconds, elapsed.count());
+            }
+        } catch (std::exception &e) {
+            std::fprintf(stderr, "ERROR: %s: %s\n", shape.c_str(), e.what());
+            report.failed = 1;
+        }
+        ssize_t written = write(fds[1], &report, sizeof report);
+        _exit(written == sizeof report ? 0 : 1);
+    }
+    close(fds[1]);
+    ChildReport report{};
+    ssize_t got = read(fds[0], &report, sizeof report);
+    close(fds[0]);
+    int status;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    if (got != sizeof report || report.failed || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw std::runtime_error ("benchmark of " + stage + " on " + shape + " failed");
+    }
+    BenchResult result;
+    result.stage = stage;
+    result.shape = shape;
+    result.bytes = report.bytes;
+    result.tokens = report.tokens;
+    result.seconds = report.seconds;
+    result.allocations = report.allocations;
+    result.peakRssKb = usage.ru_maxrss;
+    return result;
+}
+
+const char BASELINE_HEADER[] =
+    "stage\tshape\tbytes\tmb_per_s\ttokens_per_s\tallocs_per_token\tpeak_rss_kb";
+
+inline std::string baselineKey(const std::string &stage, const std::string &shape, const uint64_t bytes) {
+    return stage + '\t' + shape + '\t' + std::to_string(bytes);
+}
+
+// return the rows of a baseline file by key; a missing file has no rows
+inline std::map<std::string, std::vector<double>> readBaseline(const std::string &path) {
+    std::map<std::string, std::vector<double>> rows;
+    std::ifstream in{path};
+    std::string line;
+    if (!std::getline(in, line))  return rows;
+    if (line != BASELINE_HEADER)  throw std::runtime_error ("Not a baseline file: " + path);
+    while (std::getline(in, line)) {
+        std::istringstream fields{line};
+        std::string stage, shape;
+        uint64_t bytes;
+        std::vector<double> values(4);
+        fields >> stage >> shape >> bytes >> values[0] >> values[1] >> values[2] >> values[3];
+        if (!fields)  throw std::runtime_error ("Malformed baseline row: " + line);
+        rows[baselineKey(stage, shape, bytes)] = values;
+    }
+    return rows;
+}
+
+inline std::vector<double> baselineValues(const BenchResult &r) {
+    return {r.mbPerSec(), r.tokensPerSec(), r.allocsPerToken(), double(r.peakRssKb)};
+}
+
+inline void saveBaseline(const std::string &path, const std::vector<BenchResult> &results) {
+    auto rows = readBaseline(path);
+    for ( const BenchResult &r : results ) {
+        rows[baselineKey(r.stage, r.shape, r.bytes)] = baselineValues(r);
+    }
+    std::ofstream file{path};
+    file << BASELINE_HEADER << '\n';
+    for ( const auto &[key, values] : rows ) {
+        char line[160];
+        std::snprintf(line, sizeof line, "\t%.3f\t%.0f\t%.6f\t%.0f\n", values[0], values[1], values[2], values[3]);
+        file << key << line;
+    }
+    if (!file)  throw std::runtime_error ("Could not write baseline " + path);
+}
+
+// return the percentage change from before to now
+inline double percentChange(const double before, const double now) {
+    return before == 0 ? 0 : (now - before) / before * 100;
+}
+
+// Print the change of each result against the baseline; return false if
+// throughput dropped or peak RSS grew by more than the tolerance, or if
+// allocations per token grew at all
+inline bool compareBaseline(const std::string &path, const std::vector<BenchResult> &results,
+                            const double tolerance) {
+    auto rows = readBaseline(path);
+    bool ok = true;
+    for ( const BenchResult &r : results ) {
+        auto it = rows.find(baselineKey(r.stage, r.shape, r.bytes));
+        char line[200];
+        if (it == rows.end()) {
+            std::snprintf(line, sizeof line, "%-10s %-13s not in baseline\n", r.stage.c_str(), r.shape.c_str());
+            out << line;
+            continue;
+        }
+        const std::vector<double> &before = it->second;
+        std::vector<double> now = baselineValues(r);
+        bool regressed = percentChange(before[0], now[0]) < -tolerance ||
+                         percentChange(before[1], now[1]) < -tolerance ||
+                         now[2] > before[2] + 0.000001 ||
+                         percentChange(before[3], now[3]) > tolerance;
+        ok &= !regressed;
+        std::snprintf(line, sizeof line, "%-10s %-13s MB/s %+7.1f%%  tokens/s %+7.1f%%  allocs/token %+.6f  peak RSS %+7.1f%%  %s\n",
+                      r.stage.c_str(), r.shape.c_str(), percentChange(before[0], now[0]),
+                      percentChange(before[1], now[1]), now[2] - before[2],
+                      percentChange(before[3], now[3]), regressed ? "REGRESSION" : "ok");
+        out << line;
+    }
+    return ok;
+}
+
+// A stage to measure: how to generate each of its shapes of input and
+// how to scan one. scan returns the number of tokens it produced.
+struct BenchStage {
+    std::string name;
+    std::vector<std::string> shapes;
+    std::function<std::string(const std::string &, size_t)> generate;
+    std::function<size_t(std::string_view)> scan;
+};
+
+// Measure every stage on each of its requested shapes, print one table,
+// and save or compare a baseline. return the exit status of the benchmark
+// program.
+inline int runBench(const std::vector<BenchStage> &stages, const BenchOptions &opts) {
+    size_t bytes = opts.megabytes * 1e6;
+    std::vector<BenchResult> results;
+    char line[200];
+    std::snprintf(line, sizeof line, "%-10s %-13s %10s %9s %12s %12s %12s\n",
+                  "stage", "shape", "bytes", "MB/s", "tokens/s", "allocs/token", "peak RSS kB");
+    out << line;
+    for ( const BenchStage &stage : stages ) {
+        for ( const std::string &shape : stage.shapes ) {
+            if (!opts.shape.empty() && shape != opts.shape)  continue;
+            BenchResult r = measure(stage.name, shape, opts.runs,
+                                    [&] { return stage.generate(shape, bytes); }, stage.scan);
+            std::snprintf(line, sizeof line, "%-10s %-13s %10llu %9.2f %12.0f %12.6f %12llu\n",
+                          stage.name.c_str(), shape.c_str(), (unsigned long long)r.bytes, r.mbPerSec(),
+                          r.tokensPerSec(), r.allocsPerToken(), (unsigned long long)r.peakRssKb);
+            out << line;
+            results.push_back(r);
+        }
+    }
+    if (results.empty())  throw std::runtime_error ("Unknown shape " + opts.shape);
+    bool ok = true;
+    if (!opts.comparePath.empty())  ok = compareBaseline(opts.comparePath, results, opts.tolerance);
+    if (!opts.savePath.empty())  saveBaseline(opts.savePath, results);
+    return ok ? 0 : 2;
+}
+
+inline int runBench(const std::string &stage, const std::vector<std::string> &shapes,
+                    const std::function<std::string(const std::string &, size_t)> &generate,
+                    const std::function<size_t(std::string_view)> &scan, const BenchOptions &opts) {
+    return runBench(std::vector<BenchStage>{{stage, shapes, generate, scan}}, opts);
+}
+
+#endif
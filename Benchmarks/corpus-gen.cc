@@ -0,0 +1,31 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "corpus.h"
+#include "../Common/output.h"
+
+using namespace std;
+
+// Usage: corpus-gen wlp4|mips shape bytes [seed]
+// Writes a synthetic source of about the given size to standard output,
+// e.g. to feed a whole pipeline: corpus-gen wlp4 nested 1000000 | wlp4scan
+int main(int argc, char *argv[]) {
+  try {
+    if (argc < 4 || argc > 5) {
+        throw runtime_error ("Usage: corpus-gen wlp4|mips shape bytes [seed]");
+    }
+    string language = argv[1];
+    string shape = argv[2];
+    size_t bytes = strtoull(argv[3], nullptr, 10);
+    uint64_t seed = argc == 5 ? strtoull(argv[4], nullptr, 10) : 1;
+    if (language == "wlp4")  out << wlp4Corpus(shape, bytes, seed);
+    else if (language == "mips")  out << mipsCorpus(shape, bytes, seed);
+    else throw runtime_error ("Unknown language: " + language);
+  } catch (runtime_error &e) {
+    cerr << "ERROR: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
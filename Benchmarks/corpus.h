@@ -0,0 +1,290 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Deterministic generators of synthetic scanner inputs. The same shape,
+// size and seed always give the same bytes, on every platform, so
+// benchmark results can be compared across builds and machines.
+//
+// The WLP4 sources are whole programs that the parser, type checker and
+// code generator accept; the MIPS sources are programs the assembler
+// accepts. Each shape stresses one part of the scanner:
+//   identifiers   long variable names
+//   numbers       dense numeric literals
+//   comments      more comment bytes than code
+//   nested        deeply nested while/if blocks, so mostly indentation
+// and for MIPS: instructions, words (.word literals), comments, labels.
+
+const std::vector<std::string> WLP4_SHAPES = {"identifiers", "numbers", "comments", "nested"};
+const std::vector<std::string> MIPS_SHAPES = {"instructions", "words", "comments", "labels"};
+
+// xorshift64*, chosen over <random> because its output is fully specified
+class CorpusRandom {
+    uint64_t state;
+
+  public:
+    explicit CorpusRandom(const uint64_t seed) : state{seed * 2654435761u + 0x9E3779B97F4A7C15u} {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Du;
+    }
+
+    // return a value in [0, n)
+    uint64_t below(const uint64_t n) { return next() % n; }
+
+    // return true with probability percent/100
+    bool chance(const unsigned percent) { return below(100) < percent; }
+};
+
+const std::string_view COMMENT_WORDS[] = {
+    "the", "scanner", "reads", "each", "token", "once", "while", "loop",
+    "counter", "value", "returns", "pointer", "array", "index", "update",
+    "check", "bound", "before", "after", "result", "stored", "in", "memory",
+};
+
+inline void appendComment(std::string &s, CorpusRandom &rng, const size_t length) {
+    size_t start = s.size();
+    while (s.size() - start < length) {
+        s += ' ';
+        s += COMMENT_WORDS[rng.below(std::size(COMMENT_WORDS))];
+    }
+}
+
+// return a name of the given length; the prefix keeps it clear of keywords
+inline std::string corpusName(CorpusRandom &rng, const char prefix, const size_t length) {
+    static const char ALNUM[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    std::string name(1, prefix);
+    while (name.size() < length)  name += ALNUM[rng.below(62)];
+    return name;
+}
+
+// Writes one WLP4 program procedure by procedure
+class WLP4CorpusWriter {
+    const std::string shape;
+    CorpusRandom rng;
+    std::string &s;
+    std::vector<std::string> vars;
+    int depth = 0;
+
+    void indent() { s.append(2 * depth, ' '); }
+
+    void comment() {
+        indent();
+        s += "//";
+        appendComment(s, rng, 40 + rng.below(60));
+        s += '\n';
+    }
+
+    void operand() {
+        bool number = shape == "numbers" ? rng.chance(85) : rng.chance(20);
+        if (number)  s += std::to_string(rng.below(shape == "numbers" ? 2147483647u : 1000) + 1);
+        else s += vars[rng.below(vars.size())];
+    }
+
+    void expr() {
+        static const char *const OPS[] = {" + ", " - ", " * ", " / ", " % "};
+        operand();
+        size_t terms = shape == "numbers" ? 3 + rng.below(6) : rng.below(4);
+        for (size_t i = 0; i < terms; ++i) {
+            s += OPS[rng.below(5)];
+            operand();
+        }
+    }
+
+    void test() {
+        static const char *const OPS[] = {" < ", " <= ", " > ", " >= ", " == ", " != "};
+        expr();
+        s += OPS[rng.below(6)];
+        expr();
+    }
+
+    void block(const unsigned statements) {
+        ++depth;
+        for (unsigned i = 0; i < statements; ++i)  statement();
+        --depth;
+    }
+
+    void statement() {
+        if (shape == "comments")  comment();
+        // nested blocks hold a single statement, so each one is a chain of
+        // blocks rather than a tree that grows without bound
+        bool nested = shape == "nested";
+        unsigned nestChance = nested ? (depth < 24 ? 90 : 0) : (depth < 3 ? 15 : 0);
+        unsigned blockSize = nested ? 1 : 1 + rng.below(2);
+        if (rng.chance(nestChance)) {
+            indent();
+            if (rng.chance(50)) {
+                s += "while (";
+                test();
+                s += ") {\n";
+                block(blockSize);
+                indent();
+                s += "}\n";
+            }
+            else {
+                s += "if (";
+                test();
+                s += ") {\n";
+                block(blockSize);
+                indent();
+                s += "} else {\n";
+                block(nested ? 0 : rng.below(2));
+                indent();
+                s += "}\n";
+            }
+            return;
+        }
+        indent();
+        if (rng.chance(10)) {
+            s += "println(";
+            expr();
+            s += ");\n";
+            return;
+        }
+        s += vars[rng.below(vars.size())];
+        s += " = ";
+        expr();
+        s += ";";
+        if (shape == "comments" && rng.chance(50)) {
+            s += " //";
+            appendComment(s, rng, 20 + rng.below(40));
+        }
+        s += '\n';
+    }
+
+    // Write a procedure, or wain if name is empty
+    void procedure(const std::string &name) {
+        vars.clear();
+        size_t numVars = shape == "identifiers" ? 12 : 4;
+        for (size_t i = 0; i < numVars; ++i) {
+            vars.push_back(shape == "identifiers" ? corpusName(rng, 'v', 8 + rng.below(24))
+                                                  : "v" + std::to_string(i));
+        }
+        s += name.empty() ? "int wain(int pa, int pb) {\n" : "int " + name + "(int pa, int pb) {\n";
+        depth = 1;
+        for ( const std::string &v : vars ) {
+            indent();
+            s += "int " + v + " = " + std::to_string(rng.below(100)) + ";\n";
+        }
+        for (unsigned i = 0; i < 8; ++i)  statement();
+        indent();
+        s += "return " + vars[0] + ";\n}\n";
+        depth = 0;
+    }
+
+  public:
+    WLP4CorpusWriter(const std::string &shape, const uint64_t seed, std::string &s) :
+        shape{shape}, rng{seed}, s{s} {}
+
+    void write(const size_t bytes) {
+        for (size_t n = 0; s.size() < bytes; ++n) {
+            if (shape == "comments")  comment();
+            procedure("proc" + std::to_string(n));
+        }
+        procedure("");
+    }
+};
+
+// return a WLP4 program of about the given size in bytes (it ends with
+// wain, so it can be slightly larger)
+inline std::string wlp4Corpus(const std::string &shape, const size_t bytes, const uint64_t seed = 1) {
+    bool known = false;
+    for ( const std::string &k : WLP4_SHAPES ) { known |= k == shape; }
+    if (!known)  throw std::runtime_error ("Unknown WLP4 corpus shape: " + shape);
+    std::string s;
+    s.reserve(bytes + 4096);
+    WLP4CorpusWriter(shape, seed, s).write(bytes);
+    return s;
+}
+
+inline std::string mipsRegister(CorpusRandom &rng) {
+    return "$" + std::to_string(rng.below(32));
+}
+
+// return a MIPS assembly program of about the given size in bytes
+inline std::string mipsCorpus(const std::string &shape, const size_t bytes, const uint64_t seed = 1) {
+    bool known = false;
+    for ( const std::string &k : MIPS_SHAPES ) { known |= k == shape; }
+    if (!known)  throw std::runtime_error ("Unknown MIPS corpus shape: " + shape);
+    static const char *const THREE_REG[] = {"add", "sub", "slt", "sltu"};
+    static const char *const TWO_REG[] = {"mult", "multu", "div", "divu"};
+    static const char *const ONE_REG[] = {"mfhi", "mflo", "lis", "jr", "jalr"};
+    CorpusRandom rng{seed};
+    std::string s;
+    s.reserve(bytes + 256);
+    // branches only reach back to recent labels, so offsets fit 16 bits
+    std::vector<std::string> labels;
+    s += "start:\n";
+    labels.push_back("start");
+    while (s.size() < bytes) {
+        if (labels.size() > 64)  labels.erase(labels.begin() + 1, labels.begin() + 33);
+        unsigned labelChance = shape == "labels" ? 40 : 5;
+        if (rng.chance(labelChance)) {
+            labels.push_back(shape == "labels" ? corpusName(rng, 'L', 12 + rng.below(20))
+                                               : "L" + std::to_string(s.size()));
+            s += labels.back() + ":";
+            if (!rng.chance(30))  s += '\n';
+            else s += ' ';
+            continue;
+        }
+        if (shape == "comments" && rng.chance(40)) {
+            s += ";";
+            appendComment(s, rng, 30 + rng.below(70));
+            s += '\n';
+            continue;
+        }
+        unsigned wordChance = shape == "words" ? 80 : 10;
+        if (rng.chance(wordChance)) {
+            s += ".word ";
+            unsigned pick = rng.below(4);
+            if (pick == 0)  s += labels[rng.below(labels.size())];
+            else if (pick == 1) {
+                static const char HEX[] = "0123456789abcdefABCDEF";
+                s += "0x";
+                for (unsigned d = 1 + rng.below(8); d > 0; --d)  s += HEX[rng.below(22)];
+            }
+            else if (pick == 2)  s += "-" + std::to_string(rng.below(2147483648u) + 1);
+            else s += std::to_string(rng.below(4294967296u));
+        }
+        else {
+            switch (rng.below(6)) {
+                case 0: case 1:
+                    s += std::string(THREE_REG[rng.below(4)]) + " " + mipsRegister(rng) + ", "
+                         + mipsRegister(rng) + ", " + mipsRegister(rng);
+                    break;
+                case 2:
+                    s += std::string(TWO_REG[rng.below(4)]) + " " + mipsRegister(rng) + ", " + mipsRegister(rng);
+                    break;
+                case 3:
+                    s += std::string(ONE_REG[rng.below(5)]) + " " + mipsRegister(rng);
+                    break;
+                case 4:
+                    s += std::string(rng.chance(50) ? "lw " : "sw ") + mipsRegister(rng) + ", "
+                         + std::to_string((int)rng.below(65536) - 32768) + "(" + mipsRegister(rng) + ")";
+                    break;
+                default:
+                    s += std::string(rng.chance(50) ? "beq " : "bne ") + mipsRegister(rng) + ", "
+                         + mipsRegister(rng) + ", ";
+                    if (rng.chance(50))  s += labels[labels.size() - 1 - rng.below(std::min<size_t>(labels.size(), 8))];
+                    else s += std::to_string((int)rng.below(200) - 100);
+            }
+        }
+        if (shape == "comments" && rng.chance(50)) {
+            s += " ;";
+            appendComment(s, rng, 10 + rng.below(40));
+        }
+        s += '\n';
+    }
+    if (s.back() != '\n')  s += '\n';
+    return s;
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+#include "../WLP4Parser/lr-gen.h"
+#include "../WLP4Parser/wlp4parse.h"
+#include "../Common/output.h"
+
+using namespace std;
+
+struct TableSize {
+    size_t states;
+    size_t transitions;
+    size_t reductions;  // not counting .ACCEPT
+    size_t symbols;
+
+    // bytes of the dense action and goto arrays of lr-table.h
+    size_t denseBytes() const { return states * symbols * 2 * sizeof(int16_t); }
+};
+
+void printRow(const char *tables, const string &ms, const string &lr0States, const TableSize &size) {
+    char line[160];
+    snprintf(line, sizeof line, "%-8s %10s %12s %7zu %12zu %11zu %12zu\n", tables, ms.c_str(),
+             lr0States.c_str(), size.states, size.transitions, size.reductions, size.denseBytes());
+    out << line;
+}
+
+// Usage: lr-gen-bench [--runs N]
+// Times generating the SLR(1) and LALR(1) tables of the WLP4 grammar
+// (the best of N runs, default 20) and compares their size with that of
+// the tables shipped in wlp4data.h.
+int main(int argc, char *argv[]) {
+  try {
+    unsigned long runs = 20;
+    if (argc == 3 && string(argv[1]) == "--runs") {
+        char *end;
+        errno = 0;
+        runs = strtoul(argv[2], &end, 10);
+        // strtoul would skip leading spaces and accept (and negate) a sign
+        if (!isdigit(static_cast<unsigned char>(*argv[2])) || *end != '\0' || errno == ERANGE) {
+            throw runtime_error ("Invalid number of runs: " + string(argv[2]));
+        }
+    }
+    else if (argc != 1)  throw runtime_error ("Usage: lr-gen-bench [--runs N]");
+    if (runs == 0)  throw runtime_error ("--runs needs at least one run");
+
+    char header[160];
+    snprintf(header, sizeof header, "%-8s %10s %12s %7s %12s %11s %12s\n", "tables", "ms", "LR(0) states",
+             "states", "transitions", "reductions", "dense bytes");
+    out << header;
+    TableSize shipped{WLP4_LR.numStates(), 0, 0, WLP4_LR.numSymbols()};
+    for (size_t i = 0; i < WLP4_LR.actions.size(); ++i) {
+        if (WLP4_LR.actions[i] >= 0)  ++shipped.transitions;
+        else if (WLP4_LR.actions[i] != WLP4_LR.NO_ACTION)  ++shipped.reductions;
+        if (WLP4_LR.gotos[i] >= 0)  ++shipped.transitions;
+    }
+    printRow("shipped", "-", "-", shipped);
+
+    for ( LRMethod method : {LRMethod::SLR, LRMethod::LALR} ) {
+        double best = 0;
+        LRTables tables;
+        Grammar grammar;
+        for (unsigned long run = 0; run < runs; ++run) {
+            auto start = chrono::steady_clock::now();
+            grammar = readGrammar(WLP4_CFG);
+            tables = generateLR(grammar, method);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (run == 0 || seconds < best)  best = seconds;
+        }
+        if (!tables.conflicts.empty())  throw runtime_error ("The WLP4 grammar has conflicts: " + tables.conflicts[0]);
+        TableSize size{tables.numStates(), 0, 0, grammar.numSymbols()};
+        for (size_t state = 0; state < tables.numStates(); ++state) {
+            size.transitions += tables.transitions[state].size();
+            for ( const auto &r : tables.reductions[state] ) { size.reductions += r.first != ACCEPT_LOOKAHEAD; }
+        }
+        char ms[32];
+        snprintf(ms, sizeof ms, "%.3f", best * 1000);
+        printRow(method == LRMethod::SLR ? "SLR(1)" : "LALR(1)", ms, to_string(tables.lr0States), size);
+    }
+  } catch (runtime_error &e) {
+    cerr << "ERROR: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,33 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+#include "bench.h"
+#include "corpus.h"
+#include "../WLP4Scanner/wlp4scan.h"
+#include "../MIPSScanner/mipsscan.h"
+
+using namespace std;
+
+// Usage: scan-bench [--size MB] [--runs N] [--shape name] [--save file]
+//                   [--compare file] [--tolerance percent]
+// Measures the smm of both scanners, each on its own corpus shapes (see
+// corpus.h), in one table. Both run the Scanner engine of
+// Common/scanner.h, so the rows show what each language's spec costs.
+int main(int argc, char *argv[]) {
+  try {
+    BenchOptions opts = parseBenchOptions(argc, argv);
+    return runBench({
+        {"wlp4scan", WLP4_SHAPES,
+         [](const string &shape, size_t bytes) { return wlp4Corpus(shape, bytes); },
+         [](string_view input) { return wlp4::smm(input, 0).size(); }},
+        {"mipsscan", MIPS_SHAPES,
+         [](const string &shape, size_t bytes) { return mipsCorpus(shape, bytes); },
+         [](string_view input) { return mips::smm(input).size(); }},
+    }, opts);
+  } catch (runtime_error &e) {
+    cerr << "ERROR: " << e.what() << "\n";
+    return 1;
+  }
+}
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <vector>
+
+#include "bench.h"
+#include "corpus.h"
+#include "../WLP4Scanner/wlp4scan.h"
+#include "../WLP4Parser/wlp4parse.h"
+
+using namespace std;
+
+// return the "kind lexeme" lines wlp4scan prints for input
+string scanToText(const string &input) {
+    string text;
+    for ( const wlp4::Token &tk : wlp4::smm(input, 0) ) {
+        text += wlp4::SCAN_DFA.names[tk.kind];
+        text += ' ';
+        text += tk.lexeme(input);
+        text += '\n';
+    }
+    return text;
+}
+
+// Usage: wlp4parse-bench [--size MB] [--runs N] [--shape name] [--save file]
+//                        [--compare file] [--tolerance percent]
+// Measures reading the tokens of each WLP4 corpus shape (see corpus.h)
+// and parsing them into a tree. The size is that of the WLP4 source; the
+// throughput is given in bytes and tokens of wlp4scan output.
+int main(int argc, char *argv[]) {
+  try {
+    BenchOptions opts = parseBenchOptions(argc, argv);
+    return runBench("wlp4parse", WLP4_SHAPES,
+                    [](const string &shape, size_t bytes) { return scanToText(wlp4Corpus(shape, bytes)); },
+                    [](string_view input) {
+                        vector<ParseToken> tokens;
+                        ParseTree tree;
+                        readTokens(input, tokens);
+                        parse(tokens, tree);
+                        return tokens.size();
+                    }, opts);
+  } catch (runtime_error &e) {
+    cerr << "ERROR: " << e.what() << "\n";
+    return 1;
+  }
+}
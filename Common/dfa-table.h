@@ -0,0 +1,264 @@
+#ifndef DFA_TABLE_H
+#define DFA_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+//// Compile-time lowering of a DFA file into a dense transition table.
+// The DFA file format is the one the scanners used to read at startup:
+//   .STATES       whitespace-separated state names, the first one is the
+//                 start state, accepting states are suffixed with '!'
+//   .TRANSITIONS  one "fromState chars-or-ranges... toState" per line
+//   .INPUT        optional, ignored
+// Typical use, with the DFA text available as a constexpr string_view:
+//   constexpr auto dfa = compileDFA<countDFAStates(text)>(text);
+// A malformed DFA file reaches one of the throws below during constant
+// evaluation, which turns it into a compile error.
+
+// Number of input characters covered by the transition table (ASCII)
+constexpr int ALPHABET = 128;
+// Marks a missing transition in the transition table
+constexpr uint16_t NO_STATE = 0xFFFF;
+
+template <size_t N>
+struct DFATable {
+    // State IDs are positions in the .STATES section; the start state is 0
+    std::array<std::string_view, N> names{};
+    std::array<uint64_t, N / 64 + 1> accepting{};
+    // N rows of ALPHABET next-state entries each
+    std::array<uint16_t, N * ALPHABET> table{};
+
+    constexpr size_t size() const { return N; }
+    constexpr bool isAccepting(const uint16_t state) const {
+        return (accepting[state / 64] >> (state % 64)) & 1;
+    }
+    // return the state reached from state on c, or NO_STATE if there is
+    // no such transition (including non-ASCII input and EOF)
+    constexpr uint16_t next(const uint16_t state, const int c) const {
+        if (c < 0 || c >= ALPHABET)  return NO_STATE;
+        return table[state * ALPHABET + c];
+    }
+    // check that state loops back to itself on exactly the characters
+    // accepted by inLoop, e.g. before replacing that loop by a fast skip
+    template <class Predicate>
+    constexpr bool selfLoopsOn(const uint16_t state, const Predicate inLoop) const {
+        for (int c = 0; c < ALPHABET; ++c) {
+            if ((next(state, c) == state) != inLoop(c))  return false;
+        }
+        return true;
+    }
+    // return the ID of the state with the given name, or NO_STATE
+    constexpr uint16_t stateId(const std::string_view name) const {
+        for (size_t i = 0; i < N; ++i) {
+            if (names[i] == name)  return i;
+        }
+        return NO_STATE;
+    }
+};
+
+//// Helpers for the compile-time parser, also used by dfa-print-mips
+
+constexpr bool dfaIsSpace(const char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Remove and return the next whitespace-separated word of s,
+// or an empty view if only whitespace is left
+constexpr std::string_view dfaNextWord(std::string_view &s) {
+    size_t i = 0;
+    while (i < s.size() && dfaIsSpace(s[i]))  ++i;
+    size_t j = i;
+    while (j < s.size() && !dfaIsSpace(s[j]))  ++j;
+    std::string_view word = s.substr(i, j - i);
+    s.remove_prefix(j);
+    return word;
+}
+
+// Remove and return the next line of s, without its newline
+constexpr std::string_view dfaNextLine(std::string_view &s) {
+    size_t i = s.find('\n');
+    std::string_view line = s.substr(0, i);
+    s.remove_prefix(i == std::string_view::npos ? s.size() : i + 1);
+    return line;
+}
+
+// Remove and return the last whitespace-separated word of s
+constexpr std::string_view dfaLastWord(std::string_view &s) {
+    size_t j = s.size();
+    while (j > 0 && dfaIsSpace(s[j - 1]))  --j;
+    size_t i = j;
+    while (i > 0 && !dfaIsSpace(s[i - 1]))  --i;
+    std::string_view word = s.substr(i, j - i);
+    s = s.substr(0, i);
+    return word;
+}
+
+constexpr int dfaHexValue(const char c) {
+    if ('0' <= c && c <= '9')  return c - '0';
+    if ('a' <= c && c <= 'f')  return 10 + (c - 'a');
+    if ('A' <= c && c <= 'F')  return 10 + (c - 'A');
+    return -1;
+}
+
+// A transition word after escape sequences have been replaced.
+// Only the first few characters are kept since a valid word is either
+// a single character or a three-character range.
+struct DFACharSet {
+    char chars[3]{};
+    size_t length = 0;
+    constexpr void push(const char c) {
+        if (length < 3)  chars[length] = c;
+        ++length;
+    }
+    constexpr bool isChar() const { return length == 1; }
+    constexpr bool isRange() const { return length == 3 && chars[1] == '-'; }
+};
+
+// Replace the escape sequences \s \n \r \t \xHH in a transition word;
+// any other escaped character stands for itself
+constexpr DFACharSet dfaEscape(const std::string_view s) {
+    DFACharSet result{};
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] != '\\' || i + 1 == s.size()) {
+            result.push(s[i]);
+            continue;
+        }
+        char c = s[++i];
+        if (c == 's')  result.push(' ');
+        else if (c == 'n')  result.push('\n');
+        else if (c == 'r')  result.push('\r');
+        else if (c == 't')  result.push('\t');
+        else if (c == 'x' && i + 2 < s.size() &&
+                 dfaHexValue(s[i + 1]) >= 0 && dfaHexValue(s[i + 2]) >= 0) {
+            int code = dfaHexValue(s[i + 1]) * 16 + dfaHexValue(s[i + 2]);
+            if (code >= ALPHABET) {
+                throw std::logic_error("Invalid escape sequence: not in ASCII range (0x00 to 0x7F)");
+            }
+            result.push(code);
+            i += 2;
+        }
+        else  result.push(c);
+    }
+    return result;
+}
+
+// Spell a character the way a DFA file does; the inverse of dfaEscape
+inline std::string dfaUnescape(const char c) {
+    switch (c) {
+        case ' ': return "\\s";
+        case '\n': return "\\n";
+        case '\r': return "\\r";
+        case '\t': return "\\t";
+    }
+    if (c > ' ' && c < 0x7F)  return std::string(1, c);
+    const char HEX[] = "0123456789ABCDEF";
+    unsigned char u = c;
+    return std::string{'\\', 'x', HEX[u / 16], HEX[u % 16]};
+}
+
+// Return the text following the .STATES header, which may only be
+// preceded by blank lines
+constexpr std::string_view dfaStatesSection(std::string_view text) {
+    while (true) {
+        if (text.empty()) {
+            throw std::logic_error("Expected .STATES, but found end of input.");
+        }
+        std::string_view line = dfaNextLine(text);
+        std::string_view word = dfaNextWord(line);
+        if (word == ".STATES" && dfaNextWord(line).empty())  return text;
+        if (!word.empty()) {
+            throw std::logic_error("Expected .STATES, but found something else.");
+        }
+    }
+}
+
+// Number of states declared in a DFA file
+constexpr size_t countDFAStates(const std::string_view text) {
+    std::string_view rest = dfaStatesSection(text);
+    size_t count = 0;
+    while (true) {
+        std::string_view word = dfaNextWord(rest);
+        if (word.empty()) {
+            throw std::logic_error("Unexpected end of input while reading state set: .TRANSITIONS not found.");
+        }
+        if (word == ".TRANSITIONS")  return count;
+        ++count;
+    }
+}
+
+template <size_t N>
+constexpr DFATable<N> compileDFA(const std::string_view text) {
+    static_assert(N < NO_STATE, "Too many states in DFA");
+    DFATable<N> dfa{};
+    std::string_view rest = dfaStatesSection(text);
+
+    // Store states
+    for (size_t i = 0; i < N; ++i) {
+        std::string_view name = dfaNextWord(rest);
+        if (name.size() > 1 && name.back() == '!') {
+            name.remove_suffix(1);
+            dfa.accepting[i / 64] |= uint64_t{1} << (i % 64);
+        }
+        dfa.names[i] = name;
+    }
+    dfaNextWord(rest); // .TRANSITIONS
+    dfaNextLine(rest); // rest of the .TRANSITIONS line
+
+    // Store transitions
+    for (size_t i = 0; i < dfa.table.size(); ++i) {
+        dfa.table[i] = NO_STATE;
+    }
+    while (!rest.empty()) {
+        std::string_view line = dfaNextLine(rest);
+        std::string_view first = line;
+        if (dfaNextWord(first) == ".INPUT" && dfaNextWord(first).empty()) {
+            // We ignore .INPUT sections, so we are done
+            break;
+        }
+        std::string_view words = line;
+        uint16_t fromState = dfa.stateId(dfaNextWord(words));
+        std::string_view toName = dfaLastWord(words);
+        if (toName.empty()) {
+            // Skip blank lines
+            continue;
+        }
+        std::string_view middle = words;
+        if (dfaNextWord(middle).empty()) {
+            throw std::logic_error("Incomplete transition line");
+        }
+        uint16_t toState = dfa.stateId(toName);
+        if (fromState == NO_STATE || toState == NO_STATE) {
+            throw std::logic_error("Transition line uses an undeclared state");
+        }
+        for (std::string_view word = dfaNextWord(words); !word.empty(); word = dfaNextWord(words)) {
+            DFACharSet set = dfaEscape(word);
+            char low = 0;
+            char high = 0;
+            if (set.isChar()) {
+                low = high = set.chars[0];
+            }
+            else if (set.isRange()) {
+                low = set.chars[0];
+                high = set.chars[2];
+            }
+            else {
+                throw std::logic_error("Expected character or range in transition line");
+            }
+            if (low < 0 || high < 0) {
+                throw std::logic_error("Invalid (non-ASCII) character in transition line");
+            }
+            for (int c = low; c <= high; ++c) {
+                // the first transition listed for a character wins
+                uint16_t &entry = dfa.table[fromState * ALPHABET + c];
+                if (entry == NO_STATE)  entry = toState;
+            }
+        }
+    }
+    return dfa;
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef INPUT_BUFFER_H
+#define INPUT_BUFFER_H
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The whole contents of an input file, or of stdin, as one contiguous
+// read-only buffer. Regular files are memory-mapped so the bytes are
+// never copied; pipes and terminals are read into memory in one go.
+class InputBuffer {
+    const char *data = nullptr;
+    size_t length = 0;
+    void *mapping = nullptr;
+    std::string buffer;
+
+    void load(const int fd, const std::string &name) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+            lseek(fd, 0, SEEK_CUR) == 0) {
+            void *p = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, info.st_size, MADV_SEQUENTIAL);
+                mapping = p;
+                data = static_cast<const char *>(p);
+                length = info.st_size;
+                return;
+            }
+        }
+        // Not mappable, read everything instead
+        char chunk[1 << 16];
+        while (true) {
+            ssize_t n = read(fd, chunk, sizeof chunk);
+            if (n == 0)  break;
+            if (n < 0) {
+                if (errno == EINTR)  continue;
+                throw std::runtime_error ("Could not read " + name + ": " + strerror(errno));
+            }
+            buffer.append(chunk, n);
+        }
+        data = buffer.data();
+        length = buffer.size();
+    }
+
+  public:
+    // Read from stdin
+    InputBuffer() { load(STDIN_FILENO, "standard input"); }
+
+    // Read from the named file
+    explicit InputBuffer(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error ("Could not open " + path + ": " + strerror(errno));
+        }
+        try {
+            load(fd, path);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        // a mapping stays valid after its descriptor is closed
+        close(fd);
+    }
+
+    InputBuffer(const InputBuffer &) = delete;
+    InputBuffer &operator=(const InputBuffer &) = delete;
+
+    ~InputBuffer() {
+        if (mapping)  munmap(mapping, length);
+    }
+
+    std::string_view view() const { return std::string_view(data, length); }
+};
+
+// An input file, or stdin, read a piece at a time. Unlike InputBuffer it
+// holds nothing itself, so a reader can start on the input before the
+// writer at the other end of a pipe has finished.
+class InputStream {
+    int fd;
+    std::string name;
+
+  public:
+    // Read from stdin
+    InputStream() : fd{STDIN_FILENO}, name{"standard input"} {}
+
+    // Read from the named file
+    explicit InputStream(const std::string &path) : fd{open(path.c_str(), O_RDONLY)}, name{path} {
+        if (fd < 0) {
+            throw std::runtime_error ("Could not open " + path + ": " + strerror(errno));
+        }
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    InputStream(const InputStream &) = delete;
+    InputStream &operator=(const InputStream &) = delete;
+
+    ~InputStream() {
+        if (fd != STDIN_FILENO)  close(fd);
+    }
+
+    // Store up to n bytes at buffer; return how many, or 0 at the end
+    size_t read(char *const buffer, const size_t n) {
+        while (true) {
+            ssize_t got = ::read(fd, buffer, n);
+            if (got >= 0)  return got;
+            if (errno != EINTR) {
+                throw std::runtime_error ("Could not read " + name + ": " + strerror(errno));
+            }
+        }
+    }
+};
+
+// A sliding window over an InputStream, for readers that parse their
+// input front to back. Only the bytes not yet consumed are kept, so
+// memory is bounded by the largest item a reader looks at rather than by
+// the input.
+class InputWindow {
+    static const size_t CHUNK = 1 << 16;
+    InputStream &in;
+    std::string buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    bool atEnd = false;
+
+  public:
+    explicit InputWindow(InputStream &in) : in{in} {}
+
+    InputWindow(const InputWindow &) = delete;
+    InputWindow &operator=(const InputWindow &) = delete;
+
+    // return the unconsumed bytes, reading until there are at least n of
+    // them or the input ends. The view is valid until the next peek.
+    std::string_view peek(const size_t n) {
+        while (end - begin < n && !atEnd) {
+            memmove(&buffer[0], buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+            if (buffer.size() < end + CHUNK)  buffer.resize(end + CHUNK);
+            size_t got = in.read(&buffer[0] + end, CHUNK);
+            if (got == 0)  atEnd = true;
+            end += got;
+        }
+        return std::string_view(buffer.data() + begin, end - begin);
+    }
+
+    // Drop the first n bytes of the window
+    void consume(const size_t n) { begin += n; }
+};
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef MIPS_TOKEN_STREAM_H
+#define MIPS_TOKEN_STREAM_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "token-stream.h"
+#include "input-buffer.h"
+#include "symbol-table.h"
+#include "mips-tokens.h"
+
+//// Binary token format passed from mipsscan to the assembler. Values
+// arrive parsed and lexemes interned, so the assembler needs no text
+// processing. Integers are unsigned LEB128 varints, as in token-stream.h.
+// Layout:
+//   magic      the 4 bytes "MTK1"
+//   symbols    count, then per symbol: length, bytes. Every distinct
+//              lexeme is stored once; a LABELDEF's symbol is the label
+//              without its colon, the same symbol as the IDs using it.
+//   tokens     count, then per token: kind, and unless it is a NEWLINE,
+//              its symbol. A DECINT, HEXINT or REGISTER is followed by
+//              its value, zigzag-encoded.
+
+const std::string_view MIPS_TOKEN_STREAM_MAGIC = "MTK1";
+
+struct MIPSStreamToken {
+    TokenKind kind;
+    Symbol symbol;   // NO_SYMBOL for a NEWLINE
+    int64_t value;   // of a DECINT, HEXINT or REGISTER, otherwise 0
+};
+
+inline bool hasValue(const TokenKind kind) {
+    return kind == TokenKind::DECINT || kind == TokenKind::HEXINT || kind == TokenKind::REGISTER;
+}
+
+inline uint64_t zigzag(const int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t unzigzag(const uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline bool isMIPSTokenStream(const std::string_view data) {
+    return data.substr(0, MIPS_TOKEN_STREAM_MAGIC.size()) == MIPS_TOKEN_STREAM_MAGIC;
+}
+
+inline void writeMIPSTokenStream(std::string &out, const std::vector<std::string_view> &symbols,
+                                 const std::vector<MIPSStreamToken> &tokens) {
+    out += MIPS_TOKEN_STREAM_MAGIC;
+    putVarint(out, symbols.size());
+    for ( const auto &s : symbols ) {
+        putVarint(out, s.size());
+        out += s;
+    }
+    putVarint(out, tokens.size());
+    for ( const auto &tk : tokens ) {
+        putVarint(out, static_cast<uint64_t>(tk.kind));
+        if (tk.kind == TokenKind::NEWLINE)  continue;
+        putVarint(out, tk.symbol);
+        if (hasValue(tk.kind))  putVarint(out, zigzag(tk.value));
+    }
+}
+
+// Decodes a MIPS token stream one token at a time as it is read, so
+// none of it is held in memory. Every token is checked as it
+// is read, values against the ranges mipsscan enforces, so a reader can
+// trust what it is given.
+class MIPSTokenReader {
+    static const size_t MAX_VARINT = 10;
+    InputWindow &window;
+    uint64_t remaining;
+    uint64_t numSymbols;
+
+    // Remove and return the varint at the front of the window
+    uint64_t varint() {
+        std::string_view bytes = window.peek(MAX_VARINT);
+        size_t available = bytes.size();
+        uint64_t v = getVarint(bytes);
+        window.consume(available - bytes.size());
+        return v;
+    }
+
+  public:
+    // Read the header, passing each symbol's name to onSymbol(name) in
+    // order of ID; the name is only valid during the call
+    template <typename OnSymbol>
+    MIPSTokenReader(InputWindow &window, OnSymbol &&onSymbol) : window{window} {
+        if (!isMIPSTokenStream(window.peek(MIPS_TOKEN_STREAM_MAGIC.size()))) {
+            throw std::runtime_error ("Input is not a binary MIPS token stream");
+        }
+        window.consume(MIPS_TOKEN_STREAM_MAGIC.size());
+        numSymbols = varint();
+        for (uint64_t i = 0; i < numSymbols; ++i) {
+            uint64_t length = varint();
+            std::string_view bytes = window.peek(length);
+            if (length > bytes.size())  throw std::runtime_error ("Truncated token stream");
+            onSymbol(bytes.substr(0, length));
+            window.consume(length);
+        }
+        remaining = varint();
+    }
+
+    // Read the next token into tk; return false after the last one
+    bool next(MIPSStreamToken &tk) {
+        if (remaining == 0)  return false;
+        --remaining;
+        uint64_t kind = varint();
+        if (kind >= NUM_TOKEN_KINDS)  throw std::runtime_error ("Token kind out of range in token stream");
+        tk.kind = static_cast<TokenKind>(kind);
+        tk.symbol = NO_SYMBOL;
+        tk.value = 0;
+        if (tk.kind == TokenKind::NEWLINE)  return true;
+        uint64_t symbol = varint();
+        if (symbol >= numSymbols)  throw std::runtime_error ("Symbol out of range in token stream");
+        tk.symbol = symbol;
+        if (hasValue(tk.kind)) {
+            tk.value = unzigzag(varint());
+            bool valid = tk.kind == TokenKind::DECINT ? tk.value >= -2147483648LL && tk.value <= 0xFFFFFFFFLL :
+                         tk.kind == TokenKind::HEXINT ? tk.value >= 0 && tk.value <= 0xFFFFFFFFLL :
+                                                        tk.value >= 0 && tk.value <= 31;
+            if (!valid)  throw std::runtime_error ("Value out of range in token stream");
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef MIPS_TOKENS_H
+#define MIPS_TOKENS_H
+
+#include <cstdint>
+#include <string_view>
+#include "numparse.h"
+
+// Token kinds of the MIPS assembly language, shared by the MIPS scanner
+// and the assembler
+enum class TokenKind {
+    ID, DOTID, LABELDEF, DECINT, HEXINT, REGISTER, COMMA, LPAREN, RPAREN, NEWLINE
+};
+
+const int NUM_TOKEN_KINDS = 10;
+
+constexpr std::string_view TOKEN_KIND_NAMES[NUM_TOKEN_KINDS] = {
+    "ID", "DOTID", "LABELDEF", "DECINT", "HEXINT", "REGISTER", "COMMA", "LPAREN", "RPAREN", "NEWLINE"
+};
+
+constexpr std::string_view kindName(const TokenKind kind) {
+    return TOKEN_KIND_NAMES[static_cast<int>(kind)];
+}
+
+// Look up a token kind by name; return false if there is no such kind
+constexpr bool kindFromName(const std::string_view name, TokenKind &kind) {
+    for (int i = 0; i < NUM_TOKEN_KINDS; ++i) {
+        if (TOKEN_KIND_NAMES[i] == name) {
+            kind = static_cast<TokenKind>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parse the value of a DECINT, HEXINT or REGISTER lexeme, or set 0 for
+// other kinds; return false if the value is out of range
+inline bool tokenValue(const TokenKind kind, const std::string_view lexeme, int64_t &value) {
+    switch (kind) {
+        case TokenKind::DECINT: return parseMIPSDecimal(lexeme, value);
+        case TokenKind::HEXINT: return parseMIPSHex(lexeme, value);
+        case TokenKind::REGISTER: return parseMIPSRegister(lexeme, value);
+        default: value = 0; return true;
+    }
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef NUMPARSE_H
+#define NUMPARSE_H
+
+#include <cstdint>
+#include <string_view>
+
+// Allocation-free parsers for the numeric literals of WLP4 and MIPS
+// assembly. Each one makes a single pass over the digits, checking for
+// overflow as it goes. It returns false if s is not a literal of its form
+// or is out of range, and otherwise stores the value.
+
+// s: decimal digits, with a value of at most max
+inline bool parseDecimal(const std::string_view s, const uint64_t max, uint64_t &value) {
+    if (s.empty())  return false;
+    uint64_t v = 0;
+    for ( char c : s ) {
+        unsigned d = (unsigned char)c - '0';
+        if (d > 9 || d > max || v > (max - d) / 10)  return false;
+        v = v * 10 + d;
+    }
+    value = v;
+    return true;
+}
+
+// s: hexadecimal digits in either case, with a value of at most max
+inline bool parseHex(const std::string_view s, const uint64_t max, uint64_t &value) {
+    if (s.empty())  return false;
+    uint64_t v = 0;
+    for ( char c : s ) {
+        unsigned d = (unsigned char)c - '0';
+        if (d > 9) {
+            // folds 'A'-'F' onto 'a'-'f'
+            d = ((unsigned char)c | 0x20) - 'a';
+            if (d > 5)  return false;
+            d += 10;
+        }
+        if (d > max || v > (max - d) / 16)  return false;
+        v = v * 16 + d;
+    }
+    value = v;
+    return true;
+}
+
+// WLP4 NUM: no leading zeros, at most 2147483647
+inline bool parseWLP4Num(const std::string_view s, int32_t &value) {
+    if (s.size() > 1 && s[0] == '0')  return false;
+    uint64_t v;
+    if (!parseDecimal(s, INT32_MAX, v))  return false;
+    value = v;
+    return true;
+}
+
+// MIPS DECINT: an optional '-', then a value within the union of the
+// signed and unsigned 32-bit ranges, -2147483648 to 4294967295
+inline bool parseMIPSDecimal(const std::string_view s, int64_t &value) {
+    bool negative = !s.empty() && s[0] == '-';
+    uint64_t v;
+    if (!parseDecimal(s.substr(negative), negative ? 2147483648u : UINT32_MAX, v))  return false;
+    value = negative ? -int64_t(v) : int64_t(v);
+    return true;
+}
+
+// MIPS HEXINT: "0x", then at most 0xFFFFFFFF
+inline bool parseMIPSHex(const std::string_view s, int64_t &value) {
+    uint64_t v;
+    if (s.substr(0, 2) != "0x" || !parseHex(s.substr(2), UINT32_MAX, v))  return false;
+    value = v;
+    return true;
+}
+
+// MIPS REGISTER: "$", then at most 31
+inline bool parseMIPSRegister(const std::string_view s, int64_t &value) {
+    uint64_t v;
+    if (s.empty() || s[0] != '$' || !parseDecimal(s.substr(1), 31, v))  return false;
+    value = v;
+    return true;
+}
+
+#endif
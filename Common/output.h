@@ -0,0 +1,99 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+// Thrown when output cannot be written, so that stages which report
+// errors in their input and still exit 0 can tell a failed write apart
+class OutputError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+// Buffered output straight to a file descriptor. Everything is collected
+// in a large user-space buffer and handed to write(2) once per buffer
+// fill, bypassing iostreams and their stdio synchronisation. Nothing is
+// flushed per line; the buffer is flushed when full and on flush().
+// Every stage calls flush() at the end of main, where a failed write can
+// still be reported; the flush on destruction is only a last resort.
+class Output {
+    static const size_t CAPACITY = 1 << 16;
+    int fd;
+    size_t used = 0;
+    char buffer[CAPACITY];
+
+    void writeAll(const char *data, size_t n) {
+        while (n > 0) {
+            ssize_t written = ::write(fd, data, n);
+            if (written < 0) {
+                if (errno == EINTR)  continue;
+                throw OutputError (std::string("Could not write output: ") + strerror(errno));
+            }
+            data += written;
+            n -= written;
+        }
+    }
+
+    template <class Integer>
+    Output &writeInteger(const Integer value) {
+        if (CAPACITY - used < 24)  flush();
+        used = std::to_chars(buffer + used, buffer + CAPACITY, value).ptr - buffer;
+        return *this;
+    }
+
+  public:
+    explicit Output(const int fd) : fd{fd} {}
+    Output(const Output &) = delete;
+    Output &operator=(const Output &) = delete;
+    ~Output() {
+        try {
+            flush();
+        } catch (std::runtime_error &) {
+            // too late to report it; main should have flushed already
+        }
+    }
+
+    void flush() {
+        size_t n = used;
+        used = 0;
+        writeAll(buffer, n);
+    }
+
+    void write(const char *data, const size_t n) {
+        if (n > CAPACITY - used) {
+            flush();
+            if (n >= CAPACITY) {
+                writeAll(data, n);
+                return;
+            }
+        }
+        memcpy(buffer + used, data, n);
+        used += n;
+    }
+
+    Output &operator<<(const std::string_view s) { write(s.data(), s.size()); return *this; }
+    Output &operator<<(const std::string &s) { write(s.data(), s.size()); return *this; }
+    Output &operator<<(const char *s) { write(s, strlen(s)); return *this; }
+    Output &operator<<(const char c) {
+        if (used == CAPACITY)  flush();
+        buffer[used++] = c;
+        return *this;
+    }
+    Output &operator<<(const int v) { return writeInteger(v); }
+    Output &operator<<(const long v) { return writeInteger(v); }
+    Output &operator<<(const long long v) { return writeInteger(v); }
+    Output &operator<<(const unsigned v) { return writeInteger(v); }
+    Output &operator<<(const unsigned long v) { return writeInteger(v); }
+    Output &operator<<(const unsigned long long v) { return writeInteger(v); }
+};
+
+// Standard output for every pipeline stage
+inline Output out{STDOUT_FILENO};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Number of worker threads to use when the user asks for 0 (= all cores)
+inline unsigned defaultJobs() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// Call fn(i) for every i in [0, count) on up to jobs threads, the calling
+// thread included. Indices are handed out in increasing order. Exceptions
+// do not stop the other calls; once all of them have finished, the
+// exception thrown for the lowest index (if any) is rethrown.
+template <class Function>
+void parallelFor(const size_t count, unsigned jobs, Function fn) {
+    std::vector<std::exception_ptr> errors(count);
+    std::atomic<size_t> nextIndex{0};
+    auto worker = [&]() {
+        for (size_t i = nextIndex++; i < count; i = nextIndex++) {
+            try {
+                fn(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    if (jobs > count)  jobs = count;
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < jobs; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for ( auto &t : threads ) { t.join(); }
+    for ( auto &e : errors ) {
+        if (e)  std::rethrow_exception(e);
+    }
+}
+
+#endif
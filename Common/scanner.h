@@ -0,0 +1,221 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "dfa-table.h"
+#include "source-location.h"
+
+//// The simplified maximal munch loop shared by wlp4scan and mipsscan.
+// Scanner<Spec> runs a DFA compiled by compileDFA over an input buffer.
+// The language is described by a Spec with these static members:
+//   Token                       the token type
+//   DFA                         a reference to the compiled DFATable
+//   WHITESPACE_STATE,           states whose runs are skipped in bulk
+//   COMMENT_STATE               on entering them, or NO_STATE
+//   whitespaceEnd(p, end),      return the end of the run starting at p;
+//   commentEnd(p, end)          it must be exactly what the DFA would read
+//   makeToken(state, lexeme, offset)
+//                               the post-accept hook: check the lexeme
+//                               accepted in state (throwing runtime_error
+//                               if it is invalid), pick its kind, and
+//                               return its token
+// Lexemes accepted in states whose names start with '?' are skipped
+// without calling makeToken. Getting stuck in a state that is not
+// accepting throws runtime_error. Errors, makeToken's included, have
+// where they happened appended to their message.
+//
+// scan and smm work on an input that is already in memory; scanStream
+// pulls the input through a fixed-size window instead, so tokens come
+// out while the rest is still being read.
+
+template <typename Spec>
+class Scanner {
+  public:
+    typedef typename Spec::Token Token;
+
+  private:
+    // What the loop does when it gets stuck in each state
+    enum class Accept : uint8_t { REJECT, SKIP, TOKEN };
+
+    static constexpr std::array<Accept, Spec::DFA.size()> makeAccepts () {
+        std::array<Accept, Spec::DFA.size()> accepts{};
+        for (uint16_t state = 0; state < Spec::DFA.size(); ++state) {
+            if (!Spec::DFA.isAccepting(state))  accepts[state] = Accept::REJECT;
+            else if (Spec::DFA.names[state][0] == '?')  accepts[state] = Accept::SKIP;
+            else accepts[state] = Accept::TOKEN;
+        }
+        return accepts;
+    }
+
+    static constexpr std::array<Accept, Spec::DFA.size()> ACCEPTS = makeAccepts();
+    static constexpr uint16_t START_STATE = 0;
+
+    // return whether every transition out of a skipped state leads to
+    // another skipped state, so a skipped lexeme never becomes a token
+    static constexpr bool skipsStayClosed () {
+        for (uint16_t state = 0; state < Spec::DFA.size(); ++state) {
+            if (ACCEPTS[state] != Accept::SKIP)  continue;
+            for (int c = 0; c < ALPHABET; ++c) {
+                uint16_t next = Spec::DFA.next(state, c);
+                if (next != NO_STATE && ACCEPTS[next] != Accept::SKIP)  return false;
+            }
+        }
+        return true;
+    }
+
+    // Throw message with the position where() describes
+    template <typename Where>
+    [[noreturn]] static void fail(const std::string &message, Where &&where) {
+        throw std::runtime_error (message + " " + where());
+    }
+
+    // return Spec::makeToken(state, lexeme, offset), adding the position
+    // where() describes to any error it throws
+    template <typename Where>
+    static Token makeToken(const uint16_t state, const std::string_view lexeme, const size_t offset,
+                           Where &&where) {
+        try {
+            return Spec::makeToken(state, lexeme, offset);
+        } catch (std::runtime_error &e) {
+            fail(e.what(), where);
+        }
+    }
+
+  public:
+    // Scan input[begin, input.size()) as if it were the whole input,
+    // calling emit(token) for each token that is kept; token offsets are
+    // relative to the start of input. Scanning stops early when emit
+    // returns false.
+    template <typename Emit>
+    static void scan(const std::string_view input, const size_t begin, Emit &&emit) {
+        const size_t len = input.size();
+        const char *const data = input.data();
+        uint16_t p = START_STATE;
+        size_t start = begin;
+        size_t i = begin;
+        while (true) {
+            // the end of the input behaves like a character with no transitions
+            uint16_t next = i < len ? Spec::DFA.next(p, (unsigned char)data[i]) : NO_STATE;
+            if (next != NO_STATE) {
+                p = next;
+                ++i;
+                if (p == Spec::WHITESPACE_STATE) {
+                    i = Spec::whitespaceEnd(data + i, data + len) - data;
+                }
+                else if (p == Spec::COMMENT_STATE) {
+                    i = Spec::commentEnd(data + i, data + len) - data;
+                }
+                continue;
+            }
+            // stuck
+            if (p == START_STATE && i == len) {
+                return;
+            }
+            Accept accept = ACCEPTS[p];
+            if (accept == Accept::REJECT) {
+                fail("Scanning Failure", [&] { return describeLocation(input, start); });
+            }
+            if (accept == Accept::TOKEN) {
+                Token token = makeToken(p, input.substr(start, i - start), start,
+                                        [&] { return describeLocation(input, start); });
+                if (!emit(std::move(token)))  return;
+            }
+            p = START_STATE;
+            start = i;
+        }
+    }
+
+    // return the tokens of input[begin, input.size())
+    static std::vector<Token> smm(const std::string_view input, const size_t begin = 0) {
+        std::vector<Token> tokens;
+        scan(input, begin, [&](Token &&t) {
+            tokens.push_back(std::move(t));
+            return true;
+        });
+        return tokens;
+    }
+
+    // The number of bytes scanStream asks read for at a time
+    static const size_t STREAM_CHUNK = 1 << 16;
+
+    // Scan the input produced by read(buffer, n), which stores up to n
+    // bytes at buffer and returns how many it stored (0 at the end of the
+    // input), calling emit(token, lexeme) as soon as each token is
+    // accepted. Token offsets count from the start of the input; lexeme
+    // is only valid during the call. Only the current lexeme and one
+    // chunk are kept, and skipped runs are dropped as they are read, so
+    // memory is bounded by the longest token rather than the input.
+    template <typename Read, typename Emit>
+    static void scanStream(Read &&read, Emit &&emit) {
+        static_assert(skipsStayClosed(), "scanStream drops skipped text before it is accepted");
+        std::string window;
+        size_t base = 0;   // input offset of window[0]
+        size_t len = 0;    // bytes of window holding input
+        bool atEnd = false;
+        uint16_t p = START_STATE;
+        size_t start = 0;
+        size_t i = 0;
+        while (true) {
+            if (i == len && !atEnd) {
+                // out of input mid-lexeme: keep only the lexeme so far
+                // (nothing of a skipped run), then read the next chunk
+                if (ACCEPTS[p] == Accept::SKIP)  start = i;
+                memmove(&window[0], window.data() + start, len - start);
+                base += start;
+                len -= start;
+                i -= start;
+                start = 0;
+                if (window.size() < len + STREAM_CHUNK)  window.resize(len + STREAM_CHUNK);
+                size_t n = read(&window[0] + len, STREAM_CHUNK);
+                if (n == 0)  atEnd = true;
+                len += n;
+                continue;
+            }
+            const char *const data = window.data();
+            uint16_t next = i < len ? Spec::DFA.next(p, (unsigned char)data[i]) : NO_STATE;
+            if (next != NO_STATE) {
+                p = next;
+                ++i;
+                if (p == Spec::WHITESPACE_STATE) {
+                    i = Spec::whitespaceEnd(data + i, data + len) - data;
+                }
+                else if (p == Spec::COMMENT_STATE) {
+                    i = Spec::commentEnd(data + i, data + len) - data;
+                }
+                continue;
+            }
+            // stuck, and i == len only at the end of the input
+            if (p == START_STATE && i == len) {
+                return;
+            }
+            // earlier lines are gone, so positions are given as byte offsets
+            auto where = [&](size_t at) {
+                return [&, at] {
+                    return "at byte offset " + std::to_string(base + at) + ":" +
+                           sourceExcerpt(std::string_view(data, len), at);
+                };
+            };
+            Accept accept = ACCEPTS[p];
+            if (accept == Accept::REJECT) {
+                fail("Scanning Failure", where(start));
+            }
+            if (accept == Accept::TOKEN) {
+                std::string_view lexeme(data + start, i - start);
+                emit(makeToken(p, lexeme, base + start, where(start)), lexeme);
+            }
+            p = START_STATE;
+            start = i;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef SIMD_SKIP_H
+#define SIMD_SKIP_H
+
+#include <cstdint>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//// Vectorised skipping of whitespace and comment runs for the scanners.
+// Each function returns the first position in [p, end) that does not
+// continue the run, or end. They process 32 bytes at a time with AVX2,
+// 16 with SSE2, and finish (or run entirely, on other targets) with a
+// scalar loop.
+
+// Skip bytes equal to any of a, b, c and d
+inline const char *skipAnyOf(const char *p, const char *end,
+                             const char a, const char b, const char c, const char d) {
+#if defined(__AVX2__)
+    const __m256i a32 = _mm256_set1_epi8(a);
+    const __m256i b32 = _mm256_set1_epi8(b);
+    const __m256i c32 = _mm256_set1_epi8(c);
+    const __m256i d32 = _mm256_set1_epi8(d);
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, a32), _mm256_cmpeq_epi8(v, b32)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, c32), _mm256_cmpeq_epi8(v, d32)));
+        uint32_t miss = ~static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (miss)  return p + __builtin_ctz(miss);
+        p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i a16 = _mm_set1_epi8(a);
+    const __m128i b16 = _mm_set1_epi8(b);
+    const __m128i c16 = _mm_set1_epi8(c);
+    const __m128i d16 = _mm_set1_epi8(d);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i hit = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, a16), _mm_cmpeq_epi8(v, b16)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, c16), _mm_cmpeq_epi8(v, d16)));
+        uint32_t miss = ~static_cast<uint32_t>(_mm_movemask_epi8(hit)) & 0xFFFF;
+        if (miss)  return p + __builtin_ctz(miss);
+        p += 16;
+    }
+#endif
+    while (p < end && (*p == a || *p == b || *p == c || *p == d))  ++p;
+    return p;
+}
+
+// Skip the body of a line comment: stop at '\n', '\r' or a non-ASCII byte
+inline const char *skipComment(const char *p, const char *end) {
+#if defined(__AVX2__)
+    const __m256i nl32 = _mm256_set1_epi8('\n');
+    const __m256i cr32 = _mm256_set1_epi8('\r');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i eol = _mm256_or_si256(_mm256_cmpeq_epi8(v, nl32), _mm256_cmpeq_epi8(v, cr32));
+        // movemask of v itself picks up the high bit of non-ASCII bytes
+        uint32_t stop = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(eol, v)));
+        if (stop)  return p + __builtin_ctz(stop);
+        p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i nl16 = _mm_set1_epi8('\n');
+    const __m128i cr16 = _mm_set1_epi8('\r');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i eol = _mm_or_si128(_mm_cmpeq_epi8(v, nl16), _mm_cmpeq_epi8(v, cr16));
+        uint32_t stop = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(eol, v)));
+        if (stop)  return p + __builtin_ctz(stop);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '\n' && *p != '\r' && static_cast<unsigned char>(*p) < 0x80)  ++p;
+    return p;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SOURCE_LOCATION_H
+#define SOURCE_LOCATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Turning byte offsets into positions for error messages. Nothing here
+// runs until an error is being reported: the scanners only track offsets,
+// and the lines before an offset are counted when it is needed.
+
+// A 1-based line and column; the column counts bytes
+struct SourceLocation {
+    size_t line;
+    size_t column;
+};
+
+// return the position of text[offset], counting newlines with memchr
+inline SourceLocation locate(const std::string_view text, const size_t offset) {
+    const char *p = text.data();
+    const char *const end = text.data() + std::min(offset, text.size());
+    size_t line = 1;
+    const char *lineStart = p;
+    while (const void *newline = memchr(p, '\n', end - p)) {
+        ++line;
+        p = static_cast<const char *>(newline) + 1;
+        lineStart = p;
+    }
+    return {line, static_cast<size_t>(end - lineStart) + 1};
+}
+
+// Excerpts of very long lines are cut down to this many bytes either
+// side of the offset
+const size_t EXCERPT_REACH = 60;
+
+// return the line of text holding text[offset] followed by a line with a
+// caret under that byte, both indented and each preceded by a newline.
+// Tabs are copied into the caret line so the caret lines up.
+inline std::string sourceExcerpt(const std::string_view text, size_t offset) {
+    if (offset > text.size())  offset = text.size();
+    size_t lineStart = offset == 0 ? std::string_view::npos : text.rfind('\n', offset - 1);
+    lineStart = lineStart == std::string_view::npos ? 0 : lineStart + 1;
+    size_t lineEnd = text.find('\n', offset);
+    if (lineEnd == std::string_view::npos)  lineEnd = text.size();
+    if (lineEnd > lineStart && text[lineEnd - 1] == '\r')  --lineEnd;
+
+    std::string excerpt = "\n    ";
+    std::string caret = "\n    ";
+    size_t from = lineStart;
+    size_t to = lineEnd;
+    if (offset - from > EXCERPT_REACH) {
+        from = offset - EXCERPT_REACH;
+        excerpt += "...";
+        caret += "   ";
+    }
+    if (to > offset && to - offset > EXCERPT_REACH) {
+        to = offset + EXCERPT_REACH;
+    }
+    excerpt.append(text.substr(from, to - from));
+    if (to < lineEnd)  excerpt += "...";
+    for (size_t k = from; k < offset; ++k) {
+        caret += text[k] == '\t' ? '\t' : ' ';
+    }
+    caret += '^';
+    return excerpt + caret;
+}
+
+// return "at line L, column C:" and an excerpt for text[offset]
+inline std::string describeLocation(const std::string_view text, const size_t offset) {
+    SourceLocation at = locate(text, offset);
+    return "at line " + std::to_string(at.line) + ", column " + std::to_string(at.column) +
+           ":" + sourceExcerpt(text, offset);
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A symbol is the ID of an interned string
+typedef uint32_t Symbol;
+const Symbol NO_SYMBOL = 0xFFFFFFFF;
+
+// Interns strings as dense 32-bit symbol IDs, keeping one copy of each
+// distinct string. IDs are handed out in order of first interning, so
+// interning a fixed list of names first gives them the IDs 0, 1, 2, ...
+class SymbolTable {
+    // a deque never moves its elements, so the views below stay valid
+    std::deque<std::string> storage;
+    std::vector<std::string_view> names;
+    std::unordered_map<std::string_view, Symbol> ids;
+
+  public:
+    Symbol intern(const std::string_view s) {
+        auto it = ids.find(s);
+        if (it != ids.end())  return it->second;
+        storage.emplace_back(s);
+        Symbol id = names.size();
+        names.push_back(storage.back());
+        ids.insert({names.back(), id});
+        return id;
+    }
+
+    // return the symbol of s, or NO_SYMBOL if s was never interned
+    Symbol find(const std::string_view s) const {
+        auto it = ids.find(s);
+        return it == ids.end() ? NO_SYMBOL : it->second;
+    }
+
+    std::string_view name(const Symbol id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//// Compact binary token format passed between the scanner and the parser.
+// All integers are unsigned LEB128 varints. Layout:
+//   magic      the 4 bytes "WTK1"
+//   kinds      count, then per kind name: length, bytes
+//   blob       length, bytes; every distinct lexeme is stored once
+//   tokens     count, then per token: kind index, blob offset, length
+
+const std::string_view TOKEN_STREAM_MAGIC = "WTK1";
+
+struct StreamToken {
+    uint32_t kind;
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct TokenStream {
+    std::vector<std::string_view> kinds;
+    std::string_view blob;
+    std::vector<StreamToken> tokens;
+    std::string_view kind(const StreamToken &tk) const { return kinds[tk.kind]; }
+    std::string_view lexeme(const StreamToken &tk) const { return blob.substr(tk.offset, tk.length); }
+};
+
+inline void putVarint(std::string &out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+// Remove and return the varint at the front of in
+inline uint64_t getVarint(std::string_view &in) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (in.empty())  throw std::runtime_error ("Truncated token stream");
+        unsigned char byte = in.front();
+        in.remove_prefix(1);
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (byte < 0x80)  return v;
+    }
+    throw std::runtime_error ("Malformed varint in token stream");
+}
+
+// Remove and return a length-prefixed byte string from the front of in
+inline std::string_view getBytes(std::string_view &in) {
+    uint64_t length = getVarint(in);
+    if (length > in.size())  throw std::runtime_error ("Truncated token stream");
+    std::string_view bytes = in.substr(0, length);
+    in.remove_prefix(length);
+    return bytes;
+}
+
+inline void writeTokenStream(std::string &out, const TokenStream &ts) {
+    out += TOKEN_STREAM_MAGIC;
+    putVarint(out, ts.kinds.size());
+    for ( const auto &k : ts.kinds ) {
+        putVarint(out, k.size());
+        out += k;
+    }
+    putVarint(out, ts.blob.size());
+    out += ts.blob;
+    putVarint(out, ts.tokens.size());
+    for ( const auto &tk : ts.tokens ) {
+        putVarint(out, tk.kind);
+        putVarint(out, tk.offset);
+        putVarint(out, tk.length);
+    }
+}
+
+// Decode a token stream; the result points into data
+inline TokenStream readTokenStream(std::string_view data) {
+    if (data.substr(0, TOKEN_STREAM_MAGIC.size()) != TOKEN_STREAM_MAGIC) {
+        throw std::runtime_error ("Input is not a binary token stream");
+    }
+    data.remove_prefix(TOKEN_STREAM_MAGIC.size());
+    TokenStream ts;
+    uint64_t numKinds = getVarint(data);
+    for (uint64_t i = 0; i < numKinds; ++i) {
+        ts.kinds.push_back(getBytes(data));
+    }
+    ts.blob = getBytes(data);
+    uint64_t numTokens = getVarint(data);
+    ts.tokens.reserve(numTokens < data.size() ? numTokens : data.size());
+    for (uint64_t i = 0; i < numTokens; ++i) {
+        // checked at full width, so no value wraps into range when
+        // narrowed into a StreamToken
+        uint64_t kind = getVarint(data);
+        uint64_t offset = getVarint(data);
+        uint64_t length = getVarint(data);
+        if (kind >= ts.kinds.size() || offset > ts.blob.size() || offset > UINT32_MAX ||
+            length > ts.blob.size() - offset || length > UINT32_MAX) {
+            throw std::runtime_error ("Token out of range in token stream");
+        }
+        StreamToken tk;
+        tk.kind = kind;
+        tk.offset = offset;
+        tk.length = length;
+        ts.tokens.push_back(tk);
+    }
+    return ts;
+}
+
+#endif
@@ -1,20 +1,63 @@
 #include <vector>
 #include <iostream>
 #include <string>
-#include <map>
+#include <string_view>
+#include <deque>
+#include "../Common/output.h"
+#include "../Common/input-buffer.h"
+#include "../Common/symbol-table.h"
+#include "../Common/mips-tokens.h"
+#include "../Common/mips-token-stream.h"
 
 using namespace std;
 
-enum class TokenKind {
-    ID, DOTID, LABELDEF, DECINT, HEXINT, REGISTER, COMMA, LPAREN, RPAREN, NEWLINE
+// The mnemonics the assembler knows. They are interned before anything
+// else, so the symbol of each is its value here and an opcode is checked
+// with one integer comparison.
+enum Mnemonic : Symbol {
+    ADD, SUB, SLT, SLTU, BEQ, BNE, MULT, MULTU, DIV, DIVU,
+    MFHI, MFLO, LIS, JR, JALR, LW, SW, WORD, NUM_MNEMONICS
 };
 
+const string_view MNEMONIC_NAMES[NUM_MNEMONICS] = {
+    "add", "sub", "slt", "sltu", "beq", "bne", "mult", "multu", "div", "divu",
+    "mfhi", "mflo", "lis", "jr", "jalr", "lw", "sw", ".word"
+};
+
+SymbolTable makeSymbols () {
+    SymbolTable table;
+    for ( const auto &name : MNEMONIC_NAMES ) { table.intern(name); }
+    return table;
+}
+
+// Every lexeme, interned; a label's symbol is its name without the colon
+SymbolTable symbols = makeSymbols();
+
 struct Token {
     TokenKind kind;
-    string lexeme;
-    explicit Token (const TokenKind kind, const string lexeme): kind{kind}, lexeme{lexeme} {}
+    Symbol lexeme;  // NO_SYMBOL for a NEWLINE
+    int64_t value;  // of a DECINT, HEXINT or REGISTER, parsed once on reading
+    explicit Token (const TokenKind kind, const Symbol lexeme, const int64_t value):
+        kind{kind}, lexeme{lexeme}, value{value} {}
+    // return the lexeme, for error messages
+    string text () const {
+        string name(symbols.name(lexeme));
+        return kind == TokenKind::LABELDEF ? name + ":" : name;
+    }
 };
 
+// One assembled line, packed. A label operand is left out until the
+// label's address is known: word then holds the rest of the instruction
+// (0 for .word, the opcode and registers for beq and bne) and label the
+// symbol of the label, for patch to fill in.
+struct Instr {
+    uint32_t word;
+    Symbol label;   // NO_SYMBOL once the line is complete
+    uint32_t next;  // the previous line waiting for the same label
+};
+
+const uint32_t NO_LINE = 0xFFFFFFFF;
+
 // struct Label {
 //     string name;
 //     int address;
@@ -25,76 +68,10 @@ struct Token {
 //     }
 // };
 
-TokenKind tKindConverter (const string kind) {
-    if (kind == "ID")  return TokenKind::ID;
-    else if (kind == "DOTID")  return TokenKind::DOTID;
-    else if (kind == "LABELDEF")  return TokenKind::LABELDEF;
-    else if (kind == "DECINT")  return TokenKind::DECINT;
-    else if (kind == "HEXINT")  return TokenKind::HEXINT;
-    else if (kind == "REGISTER")  return TokenKind::REGISTER;
-    else if (kind == "COMMA")  return TokenKind::COMMA;
-    else if (kind == "LPAREN")  return TokenKind::LPAREN;
-    else if (kind == "RPAREN")  return TokenKind::RPAREN;
-    else if (kind == "NEWLINE") return TokenKind::NEWLINE;
-    else throw runtime_error ("token kind not found");
-}
-
-// converting string num (DECINT) to int value
-int decConverter (const string num) {
-    int acc = 0;
-    int len = num.length();
-    if (num[0] != '-') { // unsigned DECINT
-        for (int i = 0; i < len; ++i) {
-            acc *= 10;
-            acc += num[i] - '0';
-        }
-    }
-    else { // negative signed DECINT
-        for (int i = 1; i < len; ++i) {
-            acc *= 10;
-            acc -= num[i] - '0';
-        }
-    }
-    return acc;
-}
-
-int hexValue (const char num) {
-    switch (num) {
-        case 'A':
-        case 'a': return 10;
-        case 'B':
-        case 'b': return 11;
-        case 'C':
-        case 'c': return 12;
-        case 'D':
-        case 'd': return 13;
-        case 'E':
-        case 'e': return 14;
-        case 'F':
-        case 'f': return 15;
-        default: return num - '0';
-    }
-}
-
-// converting string num (HEXINT) to int value
-int hexConverter (const string num) {
-    int acc = 0;
-    int len = num.length();
-    for (int i = 2; i < len; ++i) {
-        acc *= 16;
-        acc += hexValue(num[i]);
-    }
-    return acc;
-}
-
-int regConverter (const string num) {
-    int acc = 0;
-    int len = num.length();
-    for (int i = 1; i < len; ++i) {
-        acc *= 10;
-        acc += num[i] - '0';
-    }
-    return acc;
+TokenKind tKindConverter (const string_view kind) {
+    TokenKind tk;
+    if (!kindFromName(kind, tk))  throw runtime_error ("token kind not found");
+    return tk;
 }
 
 // // Return the address of the label. If not found, return -1;
@@ -117,8 +94,8 @@ void checkSyntax (const vector<Token> &line) {
     switch (firstInstr.kind) {
 
         case TokenKind::DOTID: {
-            if (firstInstr.lexeme != ".word") 
-                throw runtime_error ("DOTID token unrecognized: " + firstInstr.lexeme);
+            if (firstInstr.lexeme != WORD) 
+                throw runtime_error ("DOTID token unrecognized: " + firstInstr.text());
             if (lineLen <= 1)  
                 throw runtime_error ("expecting more tokens for .word, found none");
             else if (lineLen > 2)  
@@ -130,20 +107,20 @@ void checkSyntax (const vector<Token> &line) {
                 if (tk.kind != TokenKind::DECINT && 
                     tk.kind != TokenKind::HEXINT &&
                     tk.kind != TokenKind::ID)
-                    throw runtime_error ("unexpected token " + tk.lexeme + " while processing .word");
+                    throw runtime_error ("unexpected token " + tk.text() + " while processing .word");
             }
             break;
         }
 
         case TokenKind::ID: {
-            if (firstInstr.lexeme == "add" ||
-                firstInstr.lexeme == "sub" ||
-                firstInstr.lexeme == "slt" ||
-                firstInstr.lexeme == "sltu") {
+            if (firstInstr.lexeme == ADD ||
+                firstInstr.lexeme == SUB ||
+                firstInstr.lexeme == SLT ||
+                firstInstr.lexeme == SLTU) {
 
                 // Check this line have the right number of tokens
                 if (lineLen != 6)
-                    throw runtime_error ("wrong number of tokens for " + firstInstr.lexeme);
+                    throw runtime_error ("wrong number of tokens for " + firstInstr.text());
                 
                 // Check the kind of tokens are all expected
                 if (line[1].kind != TokenKind::REGISTER ||
@@ -151,15 +128,15 @@ void checkSyntax (const vector<Token> &line) {
                     line[3].kind != TokenKind::REGISTER ||
                     line[4].kind != TokenKind::COMMA ||
                     line[5].kind != TokenKind::REGISTER)
-                    throw runtime_error ("wrong kinds of tokens for " + firstInstr.lexeme);
+                    throw runtime_error ("wrong kinds of tokens for " + firstInstr.text());
             }
 
-            else if (firstInstr.lexeme == "beq" ||
-                     firstInstr.lexeme == "bne") {
+            else if (firstInstr.lexeme == BEQ ||
+                     firstInstr.lexeme == BNE) {
                 
                 // Check this line have the right number of tokens
                 if (lineLen != 6)
-                    throw runtime_error ("wrong number of tokens for " + firstInstr.lexeme);
+                    throw runtime_error ("wrong number of tokens for " + firstInstr.text());
                 
                 // Check the kind of tokens are all expected
                 if (line[1].kind != TokenKind::REGISTER ||
@@ -169,47 +146,47 @@ void checkSyntax (const vector<Token> &line) {
                     (line[5].kind != TokenKind::DECINT &&
                      line[5].kind != TokenKind::HEXINT &&
                      line[5].kind != TokenKind::ID))
-                    throw runtime_error ("wrong kinds of tokens for " + firstInstr.lexeme);
+                    throw runtime_error ("wrong kinds of tokens for " + firstInstr.text());
             }
 
-            else if (firstInstr.lexeme == "mult" ||
-                     firstInstr.lexeme == "multu" ||
-                     firstInstr.lexeme == "div" ||
-                     firstInstr.lexeme == "divu") {
+            else if (firstInstr.lexeme == MULT ||
+                     firstInstr.lexeme == MULTU ||
+                     firstInstr.lexeme == DIV ||
+                     firstInstr.lexeme == DIVU) {
                 
                 // Check this line have the right number of tokens
                 if (lineLen != 4)
-                    throw runtime_error ("wrong number of tokens for " + firstInstr.lexeme);
+                    throw runtime_error ("wrong number of tokens for " + firstInstr.text());
                 
                 // Check the kind of tokens are all expected
                 if (line[1].kind != TokenKind::REGISTER ||
                     line[2].kind != TokenKind::COMMA ||
                     line[3].kind != TokenKind::REGISTER)
-                    throw runtime_error ("wrong kinds of tokens for " + firstInstr.lexeme);
+                    throw runtime_error ("wrong kinds of tokens for " + firstInstr.text());
                 
             }
 
-            else if (firstInstr.lexeme == "mfhi" ||
-                     firstInstr.lexeme == "mflo" ||
-                     firstInstr.lexeme == "lis" ||
-                     firstInstr.lexeme == "jr" ||
-                     firstInstr.lexeme == "jalr") {
+            else if (firstInstr.lexeme == MFHI ||
+                     firstInstr.lexeme == MFLO ||
+                     firstInstr.lexeme == LIS ||
+                     firstInstr.lexeme == JR ||
+                     firstInstr.lexeme == JALR) {
                 
                 // Check this line have the right number of tokens
                 if (lineLen != 2)
-                    throw runtime_error ("wrong number of tokens for " + firstInstr.lexeme);
+                    throw runtime_error ("wrong number of tokens for " + firstInstr.text());
                 
                 // Check the kind of tokens are all expected
                 if (line[1].kind != TokenKind::REGISTER)
-                    throw runtime_error ("wrong kinds of tokens for " + firstInstr.lexeme);
+                    throw runtime_error ("wrong kinds of tokens for " + firstInstr.text());
             }
 
-            else if (firstInstr.lexeme == "lw" ||
-                     firstInstr.lexeme == "sw") {
+            else if (firstInstr.lexeme == LW ||
+                     firstInstr.lexeme == SW) {
                 
                 // Check this line have the right number of tokens
                 if (lineLen != 7)
-                    throw runtime_error ("wrong number of tokens for " + firstInstr.lexeme);
+                    throw runtime_error ("wrong number of tokens for " + firstInstr.text());
                 
                 // Check the kind of tokens are all expected
                 if (line[1].kind != TokenKind::REGISTER ||
@@ -219,75 +196,105 @@ void checkSyntax (const vector<Token> &line) {
                     line[4].kind != TokenKind::LPAREN ||
                     line[5].kind != TokenKind::REGISTER ||
                     line[6].kind != TokenKind::RPAREN)
-                    throw runtime_error ("wrong kinds of tokens for " + firstInstr.lexeme);
+                    throw runtime_error ("wrong kinds of tokens for " + firstInstr.text());
             }
 
-            else throw runtime_error ("Invalid opcode " + firstInstr.lexeme);
+            else throw runtime_error ("Invalid opcode " + firstInstr.text());
             break;
         }
         default: {
-            throw runtime_error ("Invalid instruction component " + firstInstr.lexeme);
+            throw runtime_error ("Invalid instruction component " + firstInstr.text());
         }
     }
 }
 
-// Read Tokens from cin
-void readTokens (vector<vector<Token>> &tokens, map<string, int> &labels) {
-    string w;
-    int lineIndex = 0;
-    while (cin >> w) {
-
-        // Read labels
-        TokenKind tk = tKindConverter(w);
-        while (tk == TokenKind::LABELDEF) {
+// Reads tokens printed by mipsscan as "kind lexeme" lines
+class TextTokens {
+    InputWindow &window;
 
-            cin >> w;
-            w.pop_back();
+    static bool isSpace (const char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
 
-            // Check duplicity
-            auto it = labels.find(w);
-            if (it != labels.end())
-                throw runtime_error ("Duplicate label " + w);
-            
-            // store label
-            labels.insert({w, lineIndex * 4});
-            cin >> w;
-            tk = tKindConverter(w);
+    // return the next whitespace-separated word, valid until the next
+    // call, or an empty view at the end of the input
+    string_view nextWord () {
+        string_view rest = window.peek(1);
+        while (!rest.empty()) {
+            size_t i = 0;
+            while (i < rest.size() && isSpace(rest[i]))  ++i;
+            window.consume(i);
+            if (i < rest.size())  break;
+            rest = window.peek(1);
         }
+        size_t j = 0;
+        rest = window.peek(1);
+        while (true) {
+            while (j < rest.size() && !isSpace(rest[j]))  ++j;
+            if (j < rest.size())  break;
+            rest = window.peek(j + 1);
+            // the input ends with this word
+            if (rest.size() == j)  break;
+        }
+        window.consume(j);
+        return rest.substr(0, j);
+    }
 
-        // First Non-Label Token in this line
-        if (tk == TokenKind::NEWLINE)  continue;
-
-        // Not newline, create a vector representing the line
-        vector<Token> line;
-        cin >> w;
-        line.push_back(Token(tk, w));
-
-        // Read other tokens for this line
-        while (cin >> w) {
-            TokenKind kind = tKindConverter(w);
-            if (kind == TokenKind::NEWLINE)  break;
-            cin >> w;
-            line.push_back(Token(kind, w));
+  public:
+    explicit TextTokens (InputWindow &window): window{window} {}
+    // Read the next token into tk; return false at the end of the input
+    bool next (Token &tk) {
+        string_view w = nextWord();
+        if (w.empty())  return false;
+        TokenKind kind = tKindConverter(w);
+        if (kind == TokenKind::NEWLINE) {
+            tk = Token(kind, NO_SYMBOL, 0);
+            return true;
         }
+        w = nextWord();
+        if (w.empty())
+            throw runtime_error ("expecting a lexeme after " + string(kindName(kind)));
+        if (kind == TokenKind::LABELDEF)  w.remove_suffix(1);
+        int64_t value;
+        if (!tokenValue(kind, w, value))
+            throw runtime_error ("value out of range: " + string(w));
+        tk = Token(kind, symbols.intern(w), value);
+        return true;
+    }
+};
 
-        // Check the syntax for this line
-        checkSyntax(line);
-        tokens.push_back(line);
-        lineIndex += 1;
+// Reads tokens written by mipsscan --binary. Values arrive parsed, and
+// each distinct lexeme is interned once rather than once per token.
+class BinaryTokens {
+    vector<Symbol> remap;  // stream symbol to assembler symbol; filled by reader
+    MIPSTokenReader reader;
+
+  public:
+    explicit BinaryTokens (InputWindow &window):
+        reader{window, [&](const string_view name) { remap.push_back(symbols.intern(name)); }} {}
+
+    // Read the next token into tk; return false at the end of the input
+    bool next (Token &tk) {
+        MIPSStreamToken st;
+        if (!reader.next(st))  return false;
+        tk = Token(st.kind, st.symbol == NO_SYMBOL ? NO_SYMBOL : remap[st.symbol], st.value);
+        return true;
     }
-}
+};
 
 // Output the 32-bit instruction code
-void outputInstr (int instr) {
-    for (int i = 24; i >= 0; i -= 8) {
-        char byte = (instr >> i) & 0xFF;
-        cout << byte;
+void outputInstr (uint32_t instr) {
+    char bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = (instr >> (24 - 8 * i)) & 0xFF;
     }
+    out.write(bytes, 4);
 }
 
-int encode (const vector<Token> &line, const map<string, int> &labels, const int lineIndex) {
+// Encode a checked line, leaving a label operand to resolve
+Instr encode (const vector<Token> &line) {
     int instr = 0;
+    Symbol label = NO_SYMBOL;
     int index = 0;
 
     Token firstInstr = line[index];
@@ -297,25 +304,18 @@ int encode (const vector<Token> &line, const map<string, int> &labels, const int
             index += 1;
             Token tk = line[index];
             switch (tk.kind) {
-                case TokenKind::DECINT: {
-                    instr = decConverter(tk.lexeme);
-                    break;
-                }
+                case TokenKind::DECINT:
                 case TokenKind::HEXINT: {
-                    instr = hexConverter(tk.lexeme);
+                    instr = static_cast<uint32_t>(tk.value);
                     break;
                 }
                 case TokenKind::ID: {
-                    auto it = labels.find(tk.lexeme);
-                    // Check if the label is defined
-                    if (it == labels.end())
-                        throw runtime_error ("Use of undefined label " + tk.lexeme + " in .word");
-                    
-                    instr = it->second;
+                    // the address is filled in by resolve
+                    label = tk.lexeme;
                     break;
                 }
                 default: {
-                    throw runtime_error ("unexpected token " + tk.lexeme + " while processing .word");
+                    throw runtime_error ("unexpected token " + tk.text() + " while processing .word");
                 }
             }
             break;
@@ -323,201 +323,326 @@ int encode (const vector<Token> &line, const map<string, int> &labels, const int
 
         case TokenKind::ID: {
 
-            if (firstInstr.lexeme == "add" ||
-                firstInstr.lexeme == "sub" ||
-                firstInstr.lexeme == "slt" ||
-                firstInstr.lexeme == "sltu") {
+            if (firstInstr.lexeme == ADD ||
+                firstInstr.lexeme == SUB ||
+                firstInstr.lexeme == SLT ||
+                firstInstr.lexeme == SLTU) {
                 // Add register code
                 instr = (0 << 26) | 
-                        (regConverter(line[3].lexeme) << 21) |
-                        (regConverter(line[5].lexeme) << 16) |
-                        (regConverter(line[1].lexeme) << 11) | 0;
+                        (line[3].value << 21) |
+                        (line[5].value << 16) |
+                        (line[1].value << 11) | 0;
                 // Add function code
-                if (firstInstr.lexeme == "add")  instr |= 32;
-                else if (firstInstr.lexeme == "sub")  instr |= 34;
-                else if (firstInstr.lexeme == "slt")  instr |= 42;
-                else if (firstInstr.lexeme == "sltu")  instr |= 43;
+                if (firstInstr.lexeme == ADD)  instr |= 32;
+                else if (firstInstr.lexeme == SUB)  instr |= 34;
+                else if (firstInstr.lexeme == SLT)  instr |= 42;
+                else if (firstInstr.lexeme == SLTU)  instr |= 43;
             }
             
-            else if (firstInstr.lexeme == "beq" ||
-                     firstInstr.lexeme == "bne"){
+            else if (firstInstr.lexeme == BEQ ||
+                     firstInstr.lexeme == BNE){
                 // Adding register values
-                instr = (regConverter(line[1].lexeme) << 21) |
-                        (regConverter(line[3].lexeme) << 16) | 0;
+                instr = (line[1].value << 21) |
+                        (line[3].value << 16) | 0;
                 
                 // Adding opcode
-                if (firstInstr.lexeme == "beq")  instr |= (4 << 26);
+                if (firstInstr.lexeme == BEQ)  instr |= (4 << 26);
                 else  instr |= (5 << 26);
 
                 // encoding i
                 int16_t encodedI = 0;
                 if (line[5].kind == TokenKind::DECINT) {
+                    if (line[5].value < -32768 || line[5].value > 32767)
+                        throw runtime_error ("Out-of-range immediate value " +
+                                             line[5].text() + " in instruction "
+                                             + line[0].text());
 
-                    int value = decConverter(line[5].lexeme);
-                    // this DECINT is a positive number
-                    if (line[5].lexeme[0] != '-') {
-                        if (value > 32767)
-                            throw runtime_error ("Out-of-range immediate value " +
-                                                 line[5].lexeme + " in instruction "
-                                                 + line[0].lexeme);
-                        
-                        encodedI = value;
-                    }
-                    // this DECINT is a negative number
-                    else {
-                        if (value < -32768)
-                            throw runtime_error ("Out-of-range immediate value " +
-                                                 line[5].lexeme + " in instruction "
-                                                 + line[0].lexeme);
-                        
-                        encodedI = value;
-                    }
+                    encodedI = line[5].value;
                 }
                 else if (line[5].kind == TokenKind::HEXINT) {
-                    unsigned int value = hexConverter(line[5].lexeme);
-                    if (value > 0xFFFF)
+                    if (line[5].value > 0xFFFF)
                         throw runtime_error ("Out-of-range immediate value " +
-                                             line[5].lexeme + " in instruction "
-                                             + line[0].lexeme);
+                                             line[5].text() + " in instruction "
+                                             + line[0].text());
                         
-                    encodedI = value;
+                    encodedI = line[5].value;
                 }
-                else { // line[5] is a label
-                    auto it = labels.find(line[5].lexeme);
-                    // Address do not exist, throw error
-                    if (it == labels.end())
-                        throw runtime_error ("undefined label " + line[5].lexeme);
-                    
-                    // Calculate i
-                    int intI = it->second/4 - (lineIndex + 1);
-
-                    // Check if i is in range
-                    if (intI < -32768 || intI > 32767)
-                        throw runtime_error ("Out-of-range immediate value " +
-                                             line[5].lexeme + " in instruction "
-                                             + line[0].lexeme);
-                    
-                    encodedI = intI;
+                else { // line[5] is a label; i is filled in by resolve
+                    label = line[5].lexeme;
                 }
                 // encode i into instr
                 instr |= (encodedI & 0xFFFF);
             }
 
-            else if (firstInstr.lexeme == "mult" ||
-                     firstInstr.lexeme == "multu" ||
-                     firstInstr.lexeme == "div" ||
-                     firstInstr.lexeme == "divu") {
+            else if (firstInstr.lexeme == MULT ||
+                     firstInstr.lexeme == MULTU ||
+                     firstInstr.lexeme == DIV ||
+                     firstInstr.lexeme == DIVU) {
                 
                 // Adding register code
                 instr = (0 << 26) |
-                        (regConverter(line[1].lexeme) << 21) |
-                        (regConverter(line[3].lexeme) << 16) | 0;
+                        (line[1].value << 21) |
+                        (line[3].value << 16) | 0;
                 
                 // Adding function code
-                if (firstInstr.lexeme == "mult")  instr |= 24;
-                else if (firstInstr.lexeme == "multu")  instr |= 25;
-                else if (firstInstr.lexeme == "div")  instr |= 26;
+                if (firstInstr.lexeme == MULT)  instr |= 24;
+                else if (firstInstr.lexeme == MULTU)  instr |= 25;
+                else if (firstInstr.lexeme == DIV)  instr |= 26;
                 else  instr |= 27;
             }
 
-            else if (firstInstr.lexeme == "mfhi" ||
-                     firstInstr.lexeme == "mflo" ||
-                     firstInstr.lexeme == "lis") {
+            else if (firstInstr.lexeme == MFHI ||
+                     firstInstr.lexeme == MFLO ||
+                     firstInstr.lexeme == LIS) {
                 
                 // Adding register code
                 instr = (0 << 26) |
-                        (regConverter(line[1].lexeme) << 11) | 0;
+                        (line[1].value << 11) | 0;
                 
                 // Adding function code
-                if (firstInstr.lexeme == "mfhi")  instr |= 16;
-                else if (firstInstr.lexeme == "mflo")  instr |= 18;
+                if (firstInstr.lexeme == MFHI)  instr |= 16;
+                else if (firstInstr.lexeme == MFLO)  instr |= 18;
                 else  instr |= 20;
             }
 
-            else if (firstInstr.lexeme == "jr" ||
-                     firstInstr.lexeme == "jalr") {
+            else if (firstInstr.lexeme == JR ||
+                     firstInstr.lexeme == JALR) {
                 
                 // Adding register code
                 instr = (0 << 26) |
-                        (regConverter(line[1].lexeme) << 21) | 0;
+                        (line[1].value << 21) | 0;
                 
                 // Adding function code
-                if (firstInstr.lexeme == "jr")  instr |= 8;
+                if (firstInstr.lexeme == JR)  instr |= 8;
                 else  instr |= 9;
             }
 
-            else if (firstInstr.lexeme == "lw" ||
-                     firstInstr.lexeme == "sw") {
+            else if (firstInstr.lexeme == LW ||
+                     firstInstr.lexeme == SW) {
             
                 // Adding register values
-                instr = (regConverter(line[5].lexeme) << 21) |
-                        (regConverter(line[1].lexeme) << 16) | 0;
+                instr = (line[5].value << 21) |
+                        (line[1].value << 16) | 0;
                 
                 // Adding opcode
-                if (firstInstr.lexeme == "lw")  instr |= (35 << 26);
+                if (firstInstr.lexeme == LW)  instr |= (35 << 26);
                 else instr |= (43 << 26);
 
                 // encoding i
                 // encoding i
                 int16_t encodedI = 0;
                 if (line[3].kind == TokenKind::DECINT) {
+                    if (line[3].value < -32768 || line[3].value > 32767)
+                        throw runtime_error ("Out-of-range immediate value " +
+                                             line[3].text() + " in instruction "
+                                             + line[0].text());
 
-                    int value = decConverter(line[3].lexeme);
-                    // this DECINT is a positive number
-                    if (line[3].lexeme[0] != '-') {
-                        if (value > 32767)
-                            throw runtime_error ("Out-of-range immediate value " +
-                                                 line[3].lexeme + " in instruction "
-                                                 + line[0].lexeme);
-                        
-                        encodedI = value;
-                    }
-                    // this DECINT is a negative number
-                    else {
-                        if (value < -32768)
-                            throw runtime_error ("Out-of-range immediate value " +
-                                                 line[3].lexeme + " in instruction "
-                                                 + line[0].lexeme);
-                        
-                        encodedI = value;
-                    }
+                    encodedI = line[3].value;
                 }
                 else {
-                    unsigned int value = hexConverter(line[3].lexeme);
-                    if (value > 0xFFFF)
+                    if (line[3].value > 0xFFFF)
                         throw runtime_error ("Out-of-range immediate value " +
-                                             line[3].lexeme + " in instruction "
-                                             + line[0].lexeme);
+                                             line[3].text() + " in instruction "
+                                             + line[0].text());
                         
-                    encodedI = value;
+                    encodedI = line[3].value;
                 }
                 // encode i into instr
                 instr |= (encodedI & 0xFFFF);
             }
             else
-                throw runtime_error ("Invalid instruction component " + firstInstr.lexeme);
+                throw runtime_error ("Invalid instruction component " + firstInstr.text());
             break;
         }
         default: {
-            throw runtime_error ("Invalid instruction component " + firstInstr.lexeme);
+            throw runtime_error ("Invalid instruction component " + firstInstr.text());
         }
     }
-    return instr;
+    return {static_cast<uint32_t>(instr), label, NO_LINE};
 }
 
-int main () {
-    try {
-        vector<vector<Token>> lines;
-        map<string, int> labels;
+// Fill the address of instr's label, or the offset to it from
+// lineIndex, into instr
+void patch (Instr &instr, const int address, const uint32_t lineIndex) {
+    Symbol label = instr.label;
+    instr.label = NO_SYMBOL;
+
+    // .word leaves an empty word, beq and bne their opcode
+    uint32_t opcode = instr.word >> 26;
+    if (opcode == 0) {
+        instr.word = address;
+        return;
+    }
+
+    // Calculate i
+    int intI = address/4 - (static_cast<int>(lineIndex) + 1);
+
+    // Check if i is in range
+    if (intI < -32768 || intI > 32767)
+        throw runtime_error ("Out-of-range immediate value " + string(symbols.name(label)) +
+                             " in instruction " + (opcode == 4 ? "beq" : "bne"));
+
+    // encode i into instr
+    instr.word |= (intI & 0xFFFF);
+}
+
+// Assembles lines as they are read, in one pass. A line using a label
+// defined earlier is complete at once. A forward reference is threaded
+// onto the label's chain of fixups, through Instr::next, and patched
+// when the label is defined. Labels are found by symbol in flat arrays.
+// Words are written as soon as every line before them is complete, so
+// only the lines from the oldest unresolved reference on are held.
+class Assembler {
+    vector<int> addresses;     // by symbol: the label's address, or -1
+    vector<uint32_t> fixups;   // by symbol: the last line waiting for it
+    deque<Instr> held;         // the lines from heldBase on, not yet written
+    uint32_t heldBase = 0;
+    uint32_t numLines = 0;
+    // The earliest line whose operand could not be encoded, and why. It
+    // is reported once the lines before it are written, as it was when
+    // the assembler made two passes.
+    uint32_t deferredLine = NO_LINE;
+    string deferred;
+
+    void track (const Symbol label) {
+        if (label < addresses.size())  return;
+        addresses.resize(symbols.size(), -1);
+        fixups.resize(symbols.size(), NO_LINE);
+    }
+
+    void defer (const uint32_t lineIndex, const string &message) {
+        if (lineIndex >= deferredLine)  return;
+        deferredLine = lineIndex;
+        deferred = message;
+    }
+
+    // Write the complete lines at the front of held, stopping at one that
+    // waits for a label or failed
+    void flush () {
+        while (!held.empty() && held.front().label == NO_SYMBOL && heldBase != deferredLine) {
+            outputInstr(held.front().word);
+            held.pop_front();
+            heldBase += 1;
+        }
+    }
+
+  public:
+    // Define label at the address of the next line, patching the lines
+    // that were waiting for it
+    void defineLabel (const Symbol label) {
+        track(label);
+        // Check duplicity
+        if (addresses[label] != -1)
+            throw runtime_error ("Duplicate label " + string(symbols.name(label)));
+        addresses[label] = numLines * 4;
+
+        for (uint32_t k = fixups[label]; k != NO_LINE; ) {
+            Instr &instr = held[k - heldBase];
+            uint32_t next = instr.next;
+            try {
+                patch(instr, addresses[label], k);
+            } catch (runtime_error &e) {
+                defer(k, e.what());
+            }
+            k = next;
+        }
+        fixups[label] = NO_LINE;
+        flush();
+    }
+
+    // Check and assemble the next line
+    void addLine (const vector<Token> &line) {
+        checkSyntax(line);
+        Instr instr = {0, NO_SYMBOL, NO_LINE};
+        try {
+            instr = encode(line);
+            if (instr.label != NO_SYMBOL) {
+                track(instr.label);
+                if (addresses[instr.label] != -1) {
+                    patch(instr, addresses[instr.label], numLines);
+                }
+                else {
+                    instr.next = fixups[instr.label];
+                    fixups[instr.label] = numLines;
+                }
+            }
+        } catch (runtime_error &e) {
+            defer(numLines, e.what());
+        }
+        held.push_back(instr);
+        numLines += 1;
+        flush();
+    }
+
+    // Write what is left at the end of the input, or throw the error of
+    // the first line that cannot be written
+    void finish () {
+        flush();
+        if (held.empty())  return;
+        if (heldBase == deferredLine)  throw runtime_error (deferred);
+
+        // the first line held waits for a label that was never defined
+        const Instr &instr = held.front();
+        string name(symbols.name(instr.label));
+        if ((instr.word >> 26) == 0)
+            throw runtime_error ("Use of undefined label " + name + " in .word");
+        throw runtime_error ("undefined label " + name);
+    }
+};
+
+// Read tokens from source a line at a time into assembler. Only the
+// current line's tokens are held.
+template <typename Source>
+void readLines (Source &source, Assembler &assembler) {
+    Token tk(TokenKind::NEWLINE, NO_SYMBOL, 0);
+    vector<Token> line;
+    while (source.next(tk)) {
 
-        readTokens(lines, labels);
+        // Read labels
+        while (tk.kind == TokenKind::LABELDEF) {
+            assembler.defineLabel(tk.lexeme);
+            if (!source.next(tk))  return;
+        }
 
-        int numLines = lines.size();
-        for (int i = 0; i < numLines; ++i) {
-            // encode and output each line
-            int instr = encode(lines[i], labels, i);
-            outputInstr(instr);
+        // First Non-Label Token in this line
+        if (tk.kind == TokenKind::NEWLINE)  continue;
+
+        // Not newline, collect the tokens of the line
+        line.clear();
+        line.push_back(tk);
+
+        // Read other tokens for this line
+        while (source.next(tk)) {
+            if (tk.kind == TokenKind::NEWLINE)  break;
+            line.push_back(tk);
+        }
+
+        assembler.addLine(line);
+    }
+}
+
+// Usage: asm < tokens
+// Assembles the tokens on standard input, either "kind lexeme" lines
+// from mipsscan or the binary stream of mipsscan --binary, which is
+// recognised by its magic number. The input is read as it arrives and
+// machine code is written as soon as its labels are known; if an error
+// is found, the words before the failing line may already be written.
+int main () {
+    ios::sync_with_stdio(false);
+    try {
+        Assembler assembler;
+        InputStream in;
+        InputWindow window(in);
+        if (isMIPSTokenStream(window.peek(MIPS_TOKEN_STREAM_MAGIC.size()))) {
+            BinaryTokens source(window);
+            readLines(source, assembler);
+        }
+        else {
+            TextTokens source(window);
+            readLines(source, assembler);
         }
+        assembler.finish();
+        out.flush();
     }
     catch (runtime_error &e) {
         cerr << "ERROR: " << e.what() << endl;
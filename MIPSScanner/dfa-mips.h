@@ -1,5 +1,12 @@
-#include <string>
-std::string DFAstring = R"(
+#ifndef DFA_MIPS_H
+#define DFA_MIPS_H
+
+#include <string_view>
+// The MIPS assembly scanning DFA as a DFA file. mipsscan compiles it into
+// a transition table at build time, see Common/dfa-table.h.
+namespace mips {
+
+constexpr std::string_view DFAstring = R"(
 .STATES
 start
 ID!
@@ -50,3 +57,7 @@ start       \s \t ?WHITESPACE
 start    ; ?COMMENT
 ?COMMENT \x00-\x09 \x0B \x0C \x0E-\x7F ?COMMENT
 )";
+
+}
+
+#endif
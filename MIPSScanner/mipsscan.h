@@ -0,0 +1,144 @@
+#ifndef MIPSSCAN_H
+#define MIPSSCAN_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+
+//// The dfa-mips.h header defines a string constant containing a DFA file:
+// constexpr std::string_view mips::DFAstring = ...
+#include "dfa-mips.h"
+#include "../Common/dfa-table.h"
+#include "../Common/simd-skip.h"
+#include "../Common/scanner.h"
+#include "../Common/numparse.h"
+#include "../Common/mips-tokens.h"
+
+// The scanning core of mipsscan: the DFA, the token type and smm.
+// mipsscan.cc adds the command line and the output. Everything is in
+// namespace mips, so the WLP4 scanner can be used alongside it; the
+// token kinds of mips-tokens.h are shared with the assembler and stay
+// global.
+
+namespace mips {
+
+// The scanning DFA, compiled from DFAstring at build time
+constexpr auto SCAN_DFA = compileDFA<countDFAStates(DFAstring)>(DFAstring);
+
+// return the ID of a state the scanner relies on; unknown names fail the build
+constexpr uint16_t stateId (const std::string_view name) {
+    uint16_t id = SCAN_DFA.stateId(name);
+    if (id == NO_STATE)  throw std::logic_error ("DFA does not declare this state");
+    return id;
+}
+
+constexpr uint16_t WHITESPACE_STATE = stateId("?WHITESPACE");
+constexpr uint16_t COMMENT_STATE = stateId("?COMMENT");
+
+// MIPSSpec skips whitespace and comment runs with skipAnyOf and
+// skipComment, which must consume exactly what the DFA would
+static_assert(SCAN_DFA.selfLoopsOn(WHITESPACE_STATE, [](int c) { return c == ' ' || c == '\t'; }) &&
+              SCAN_DFA.selfLoopsOn(COMMENT_STATE, [](int c) { return c != '\n' && c != '\r'; }),
+              "fast skips do not match the whitespace and comment states");
+
+// What makeToken does with a lexeme accepted in a token state
+enum class StateAction : uint8_t {
+    EMIT,       // a token of the state's kind
+    DECIMAL,    // a token whose value is range-checked and kept
+    HEX,
+    REGISTER,
+};
+
+struct StateRule {
+    StateAction action;
+    TokenKind kind;
+};
+
+// return the rule of every state that yields tokens. The kind of a state
+// is the token kind of the same name, except that ZERO accepts a lone
+// "0", a DECINT.
+constexpr std::array<StateRule, SCAN_DFA.size()> makeStateRules () {
+    std::array<StateRule, SCAN_DFA.size()> rules{};
+    for (uint16_t state = 0; state < SCAN_DFA.size(); ++state) {
+        std::string_view name = SCAN_DFA.names[state];
+        if (!SCAN_DFA.isAccepting(state) || name[0] == '?')  continue;
+        TokenKind kind = TokenKind::DECINT;
+        if (name != "ZERO" && !kindFromName(name, kind)) {
+            throw std::logic_error ("accepting state has no token kind");
+        }
+        StateAction action = kind == TokenKind::DECINT ? StateAction::DECIMAL :
+                             kind == TokenKind::HEXINT ? StateAction::HEX :
+                             kind == TokenKind::REGISTER ? StateAction::REGISTER : StateAction::EMIT;
+        rules[state] = {action, kind};
+    }
+    return rules;
+}
+
+constexpr auto STATE_RULES = makeStateRules();
+
+// A token refers to its lexeme by position, so tokens own no memory and
+// scanStream can hand them out without keeping the input around
+struct Token {
+    TokenKind kind;
+    uint32_t length;
+    size_t offset;
+    int64_t value;  // of a DECINT, HEXINT or REGISTER, checked when scanned
+    Token (TokenKind kind, size_t offset, uint32_t length, int64_t value) :
+        kind{kind}, length{length}, offset{offset}, value{value} {}
+    std::string_view lexeme (const std::string_view input) const {
+        return input.substr(offset, length);
+    }
+};
+
+// The MIPS assembly language for Scanner: numbers and registers are
+// range-checked and their values kept
+struct MIPSSpec {
+    typedef mips::Token Token;
+    static constexpr const auto &DFA = SCAN_DFA;
+    static constexpr uint16_t WHITESPACE_STATE = mips::WHITESPACE_STATE;
+    static constexpr uint16_t COMMENT_STATE = mips::COMMENT_STATE;
+
+    static const char *whitespaceEnd(const char *p, const char *end) {
+        return skipAnyOf(p, end, ' ', '\t', ' ', '\t');
+    }
+    static const char *commentEnd(const char *p, const char *end) {
+        return skipComment(p, end);
+    }
+
+    static Token makeToken(const uint16_t state, const std::string_view lexeme, const size_t offset) {
+        const StateRule rule = STATE_RULES[state];
+        int64_t value = 0;
+        switch (rule.action) {
+            case StateAction::DECIMAL:
+                if (!parseMIPSDecimal(lexeme, value)) {
+                    throw std::runtime_error
+                        ("Decimal value is beyond the union of signed and unsigned ranges of 32-bit integers");
+                }
+                break;
+            case StateAction::HEX:
+                if (!parseMIPSHex(lexeme, value)) {
+                    throw std::runtime_error ("Heximal value is greater than 0xFFFFFFFF");
+                }
+                break;
+            case StateAction::REGISTER:
+                if (!parseMIPSRegister(lexeme, value)) {
+                    throw std::runtime_error ("Register value exceeds 31");
+                }
+                break;
+            case StateAction::EMIT:
+                break;
+        }
+        return Token(rule.kind, offset, lexeme.size(), value);
+    }
+};
+
+// return the tokens of input
+inline std::vector<Token> smm(const std::string_view input) {
+    return Scanner<MIPSSpec>::smm(input);
+}
+
+}
+
+#endif
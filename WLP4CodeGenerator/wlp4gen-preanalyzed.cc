@@ -3,6 +3,7 @@
 #include <sstream>
 #include <iostream>
 #include <map>
+#include "../Common/output.h"
 using namespace std;
 
 const string EMPTY = ".EMPTY";
@@ -30,7 +31,7 @@ string getLabel(string labelType) {
 }
 
 enum class TypeVariable { INT, PINT, NOTYPE };
-ostream &operator<<(ostream &out, const TypeVariable &tv) {
+Output &operator<<(Output &out, const TypeVariable &tv) {
     switch (tv) {
         case (TypeVariable::INT):
             out << " : int";
@@ -100,12 +101,12 @@ struct Node {
     }
     void print() {
         if (kind[0] <= 'Z' && kind[0] >= 'A') {
-            std::cout << kind << ' ' << lexeme << type << endl;
+            out << kind << ' ' << lexeme << type << '\n';
         } else {
-            std::cout << rule << type << endl;
+            out << rule << type << '\n';
         }
         // cout << rule << kind << ' ' << lexeme
-        //      << type << endl;
+        //      << type << '\n';
         for ( auto &n : children ) { n->print(); }
     }
     ~Node() {
@@ -115,81 +116,81 @@ struct Node {
 
 // output helper functions
 void Add(int d, int s, int t) { 
-    std::cout << "add $" << d << ", $" << s << ", $" << t << "\n"; 
+    out << "add $" << d << ", $" << s << ", $" << t << "\n"; 
 }
 void Sub(int d, int s, int t) { 
-    std::cout << "sub $" << d << ", $" << s << ", $" << t << "\n"; 
+    out << "sub $" << d << ", $" << s << ", $" << t << "\n"; 
 }
 void Mult(int s, int t) {
-    std::cout << "mult $" << s << ", $" << t << "\n";
+    out << "mult $" << s << ", $" << t << "\n";
 }
 void Multu(int s, int t) {
-    std::cout << "multu $" << s << ", $" << t << "\n";
+    out << "multu $" << s << ", $" << t << "\n";
 }
 void Div(int s, int t) {
-    std::cout << "div $" << s << ", $" << t << "\n";
+    out << "div $" << s << ", $" << t << "\n";
 }
 void Divu(int s, int t) {
-    std::cout << "divu $" << s << ", $" << t << "\n";
+    out << "divu $" << s << ", $" << t << "\n";
 }
 void Mfhi(int d) {
-    std::cout << "mfhi $" << d << "\n";
+    out << "mfhi $" << d << "\n";
 }
 void Mflo(int d) {
-    std::cout << "mflo $" << d << "\n";
+    out << "mflo $" << d << "\n";
 }
 void Lis(int d) {
-    std::cout << "lis $" << d << "\n";
+    out << "lis $" << d << "\n";
 }
 void Slt(int d, int s, int t) { 
-    std::cout << "slt $" << d << ", $" << s << ", $" << t << "\n"; 
+    out << "slt $" << d << ", $" << s << ", $" << t << "\n"; 
 }
 void Sltu(int d, int s, int t) { 
-    std::cout << "sltu $" << d << ", $" << s << ", $" << t << "\n"; 
+    out << "sltu $" << d << ", $" << s << ", $" << t << "\n"; 
 }
 void Jr(int s) { 
-    std::cout << "jr $" << s << "\n";
+    out << "jr $" << s << "\n";
 }
 void Jalr(int s) { 
-    std::cout << "jalr $" << s << "\n";
+    out << "jalr $" << s << "\n";
 }
 void Beq(int s, int t, std::string label) { 
-    std::cout << "beq $" << s << ", $" << t << ", " + label + "\n"; 
+    out << "beq $" << s << ", $" << t << ", " + label + "\n"; 
 }
 void Beq(int s, int t, int i) { 
-    std::cout << "beq $" << s << ", $" << t << ", " << i << endl; 
+    out << "beq $" << s << ", $" << t << ", " << i << '\n'; 
 }
 void Bne(int s, int t, std::string label) { 
-    std::cout << "bne $" << s << ", $" << t << ", " + label + "\n"; 
+    out << "bne $" << s << ", $" << t << ", " + label + "\n"; 
 }
 void Bne(int s, int t, int i) { 
-    std::cout << "bne $" << s << ", $" << t << ", " << i << endl; 
+    out << "bne $" << s << ", $" << t << ", " << i << '\n'; 
 }
 void Lw(int s, int t, int i) {
-    std::cout << "lw $" << t << ", " << i << "($" << s << ")\n";
+    out << "lw $" << t << ", " << i << "($" << s << ")\n";
 }
 void Sw(int s, int t, int i) {
-    std::cout << "sw $" << t << ", " << i << "($" << s << ")\n";
+    out << "sw $" << t << ", " << i << "($" << s << ")\n";
 }
 void Word(int i) {
-    std::cout << ".word " << i << "\n";
+    out << ".word " << i << "\n";
 }
 void Word(std::string label) {
-    std::cout << ".word " + label + "\n";
+    out << ".word " + label + "\n";
 }
 void Label(std::string name) {
-    std::cout << name + ":\n";
+    out << name + ":\n";
 }
 void push(int s) {
-    std::cout << "sw $" << s << ", -4($30)\n";
-    std::cout << "sub $30, $30, $4\n";
+    out << "sw $" << s << ", -4($30)\n";
+    out << "sub $30, $30, $4\n";
 }
 void pop(int d) {
-    std::cout << "add $30, $30, $4\n";
-    std::cout << "lw $" << d << ", -4($30)\n";
+    out << "add $30, $30, $4\n";
+    out << "lw $" << d << ", -4($30)\n";
 }
 void pop() {
-    std::cout << "add $30, $30, $4\n";
+    out << "add $30, $30, $4\n";
 }
 
 // code(lhs)
@@ -714,10 +715,10 @@ void codeMain(Node *n) {
     if (n->lhs != "main")
         throw runtime_error("not a main node");
     
-    std::cout << ".import print\n";
-    std::cout << ".import init\n";
-    std::cout << ".import new\n";
-    std::cout << ".import delete\n";
+    out << ".import print\n";
+    out << ".import init\n";
+    out << ".import new\n";
+    out << ".import delete\n";
 
     // init
     // store 4 in $4
@@ -794,7 +795,7 @@ void codeMain(Node *n) {
         ++nLocalVariables;
     }
 
-    std::cout << "; end of prelogue\n\n";
+    out << "; end of prelogue\n\n";
 
     // statements
     codeStatements(n->getChild("statements", 1), offsetTable);
@@ -806,13 +807,14 @@ void codeMain(Node *n) {
     // if (it != offsetTable.end()) Lw(29, 3, it->second);
     
 
-    std::cout << "\n; begin of afterlogue\n";
+    out << "\n; begin of afterlogue\n";
 
     for (int i = 0; i < nLocalVariables; ++i) { pop(); }
     Jr(31);
 }
 
 int main() {
+    ios::sync_with_stdio(false);
 
     Node *parseTree = new Node(cin);
     Node *procedures = parseTree->getChild("procedures", 1);
@@ -832,7 +834,13 @@ int main() {
             codeProcedure(procedures->getChild("procedure", 1));
             procedures = procedures->getChild("procedures", 1);
         }
+        out.flush();
     } 
+    catch (OutputError &e) {
+        cerr << "ERROR: " << e.what() << endl;
+        delete parseTree;
+        return 1;
+    }
     catch (runtime_error &e) {
         cerr << "ERROR: " << e.what() << endl;
     }
@@ -0,0 +1,41 @@
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+#include "lr-gen.h"
+#include "../Common/input-buffer.h"
+#include "../Common/output.h"
+
+using namespace std;
+
+// Usage: lr-gen [--slr] [file]
+// Reads a grammar in the .CFG format of wlp4data.h from file or stdin and
+// prints its LALR(1) tables, or with --slr its SLR(1) tables, as the
+// .TRANSITIONS and .REDUCTIONS sections that follow it there. If the
+// grammar has conflicts, they are reported instead and the exit status
+// is 1.
+int main(int argc, char *argv[]) {
+  try {
+    LRMethod method = LRMethod::LALR;
+    string path;
+    for (int i = 1; i < argc; ++i) {
+      string arg = argv[i];
+      if (arg == "--slr")  method = LRMethod::SLR;
+      else if (path.empty() && arg[0] != '-')  path = arg;
+      else throw runtime_error ("Usage: lr-gen [--slr] [file]");
+    }
+    InputBuffer in = path.empty() ? InputBuffer() : InputBuffer(path);
+    Grammar grammar = readGrammar(in.view());
+    LRTables tables = generateLR(grammar, method);
+    if (!tables.conflicts.empty()) {
+      for ( const string &c : tables.conflicts ) { cerr << "ERROR: " << c << "\n"; }
+      return 1;
+    }
+    writeLRTables(out, grammar, tables);
+    out.flush();
+  } catch (runtime_error &e) {
+    cerr << "ERROR: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
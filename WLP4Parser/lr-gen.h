@@ -0,0 +1,430 @@
+#ifndef LR_GEN_H
+#define LR_GEN_H
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lr-table.h"
+#include "../Common/output.h"
+
+//// Construction of LR parse tables from a grammar, so the grammar can
+// change without an external tool. generateLR builds the LR(0) automaton
+// of a .CFG section, gives its reductions SLR(1) or LALR(1) lookaheads,
+// merges states whose rows are equivalent and lists every conflict.
+// writeLRTables prints the result as the .TRANSITIONS and .REDUCTIONS
+// sections that lr-table.h reads.
+//
+// As in the parser, rule 0 is the start rule and is reduced once the
+// input ends, so it is written as a reduction on .ACCEPT and its left-hand
+// side may not appear on any right-hand side.
+
+struct Grammar {
+    // Symbol IDs are in order of first appearance, as in lr-table.h
+    std::vector<std::string> names;
+    std::vector<bool> nonterminal;
+    std::vector<int> lhs;
+    std::vector<std::vector<int>> rhs;
+
+    size_t numSymbols() const { return names.size(); }
+    size_t numRules() const { return lhs.size(); }
+    std::string ruleText(const size_t rule) const {
+        std::string text = names[lhs[rule]];
+        for ( int s : rhs[rule] ) { text += ' '; text += names[s]; }
+        if (rhs[rule].empty())  { text += ' '; text += LR_EMPTY; }
+        return text;
+    }
+};
+
+inline Grammar readGrammar(std::string_view text) {
+    if (dfaNextWord(text) != ".CFG")  throw std::runtime_error ("Expected .CFG");
+    dfaNextLine(text);
+    Grammar g;
+    std::map<std::string_view, int> ids;
+    auto id = [&](const std::string_view name) {
+        auto it = ids.find(name);
+        if (it != ids.end())  return it->second;
+        g.names.push_back(std::string(name));
+        g.nonterminal.push_back(false);
+        return ids[name] = g.names.size() - 1;
+    };
+    while (!text.empty()) {
+        std::string_view line = dfaNextLine(text);
+        std::string_view lhs = dfaNextWord(line);
+        if (lhs.empty())  continue;
+        if (lhs == LR_EMPTY)  throw std::runtime_error ("Rule without a left-hand side");
+        g.lhs.push_back(id(lhs));
+        g.rhs.emplace_back();
+        for (std::string_view word = dfaNextWord(line); !word.empty(); word = dfaNextWord(line)) {
+            if (word == LR_EMPTY) {
+                if (!g.rhs.back().empty() || !dfaNextWord(line).empty()) {
+                    throw std::runtime_error (".EMPTY must be the whole right-hand side");
+                }
+                break;
+            }
+            g.rhs.back().push_back(id(word));
+        }
+    }
+    if (g.lhs.empty())  throw std::runtime_error ("Grammar has no rules");
+    for ( int l : g.lhs ) { g.nonterminal[l] = true; }
+    for ( const auto &r : g.rhs ) {
+        if (std::count(r.begin(), r.end(), g.lhs[0])) {
+            throw std::runtime_error ("The start symbol " + g.names[g.lhs[0]] + " appears on a right-hand side");
+        }
+    }
+    return g;
+}
+
+enum class LRMethod { SLR, LALR };
+
+// The lookahead of a reduction of rule 0
+const int ACCEPT_LOOKAHEAD = -1;
+
+struct LRTables {
+    size_t lr0States = 0;  // before equivalent states were merged
+    // per state: (symbol, state) transitions and (lookahead, rule)
+    // reductions, each sorted
+    std::vector<std::vector<std::pair<int, int>>> transitions;
+    std::vector<std::vector<std::pair<int, int>>> reductions;
+    std::vector<std::string> conflicts;
+
+    size_t numStates() const { return transitions.size(); }
+};
+
+// Builds the tables of one grammar. An item is a rule with a dot in its
+// right-hand side, numbered so that the item after it moves the dot.
+class LRGenerator {
+    typedef std::vector<bool> SymbolSet;  // over the symbols, plus PROPAGATE
+    const Grammar &g;
+    const int PROPAGATE;  // the marker lookahead of the LALR propagation
+    std::vector<int> firstItem;   // by rule
+    std::vector<int> itemRule;    // by item
+    std::vector<std::vector<int>> rulesOf;  // by nonterminal
+    std::vector<bool> nullable;
+    std::vector<SymbolSet> first;
+
+    std::vector<std::vector<int>> kernels;  // sorted items, by state
+    std::vector<std::vector<std::pair<int, int>>> gotos;
+
+    // return the symbol after the dot of item, or -1 if it is complete
+    int next(const int item) const {
+        int rule = itemRule[item];
+        size_t dot = item - firstItem[rule];
+        return dot < g.rhs[rule].size() ? g.rhs[rule][dot] : -1;
+    }
+
+    int target(const int state, const int symbol) const {
+        const auto &row = gotos[state];
+        auto it = std::lower_bound(row.begin(), row.end(), std::make_pair(symbol, 0));
+        return it->second;
+    }
+
+    // return the items of kernel and of every rule they lead into
+    std::vector<int> closure(const std::vector<int> &kernel) const {
+        std::vector<int> items = kernel;
+        std::vector<bool> added(g.numSymbols(), false);
+        for (size_t i = 0; i < items.size(); ++i) {
+            int s = next(items[i]);
+            if (s < 0 || !g.nonterminal[s] || added[s])  continue;
+            added[s] = true;
+            for ( int r : rulesOf[s] ) { items.push_back(firstItem[r]); }
+        }
+        return items;
+    }
+
+    // the same with lookaheads: return every item reached from the
+    // kernel items and their lookaheads, with its lookaheads
+    std::map<int, SymbolSet> closure(const std::vector<std::pair<int, SymbolSet>> &kernel) const {
+        std::map<int, SymbolSet> items(kernel.begin(), kernel.end());
+        std::vector<int> work;
+        for ( const auto &k : kernel ) { work.push_back(k.first); }
+        while (!work.empty()) {
+            int item = work.back();
+            work.pop_back();
+            int s = next(item);
+            if (s < 0 || !g.nonterminal[s])  continue;
+            // lookaheads of s: FIRST of what follows it, and the item's
+            // own if all of that can be empty
+            SymbolSet lookaheads(PROPAGATE + 1, false);
+            bool rest = true;
+            for (int i = item + 1; rest && next(i) >= 0; ++i) {
+                for (int t = 0; t < PROPAGATE; ++t) { if (first[next(i)][t]) lookaheads[t] = true; }
+                rest = nullable[next(i)];
+            }
+            if (rest) {
+                const SymbolSet &own = items[item];
+                for (int t = 0; t <= PROPAGATE; ++t) { if (own[t]) lookaheads[t] = true; }
+            }
+            for ( int r : rulesOf[s] ) {
+                auto inserted = items.insert({firstItem[r], SymbolSet(PROPAGATE + 1, false)});
+                SymbolSet &theirs = inserted.first->second;
+                bool changed = inserted.second;
+                for (int t = 0; t <= PROPAGATE; ++t) {
+                    if (lookaheads[t] && !theirs[t]) { theirs[t] = true; changed = true; }
+                }
+                if (changed)  work.push_back(firstItem[r]);
+            }
+        }
+        return items;
+    }
+
+    void computeFirst() {
+        nullable.assign(g.numSymbols(), false);
+        first.assign(g.numSymbols(), SymbolSet(PROPAGATE + 1, false));
+        for (size_t s = 0; s < g.numSymbols(); ++s) {
+            if (!g.nonterminal[s])  first[s][s] = true;
+        }
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (size_t r = 0; r < g.numRules(); ++r) {
+                SymbolSet &into = first[g.lhs[r]];
+                bool allNullable = true;
+                for ( int s : g.rhs[r] ) {
+                    for (int t = 0; t < PROPAGATE; ++t) {
+                        if (first[s][t] && !into[t]) { into[t] = true; changed = true; }
+                    }
+                    if (!nullable[s]) { allNullable = false; break; }
+                }
+                if (allNullable && !nullable[g.lhs[r]]) { nullable[g.lhs[r]] = true; changed = true; }
+            }
+        }
+    }
+
+    void buildLR0() {
+        std::map<std::vector<int>, int> stateOf;
+        kernels.push_back({firstItem[0]});
+        stateOf[kernels[0]] = 0;
+        for (size_t state = 0; state < kernels.size(); ++state) {
+            std::map<int, std::vector<int>> advanced;
+            for ( int item : closure(kernels[state]) ) {
+                int s = next(item);
+                if (s >= 0)  advanced[s].push_back(item + 1);
+            }
+            gotos.emplace_back();
+            for ( auto &[symbol, kernel] : advanced ) {
+                std::sort(kernel.begin(), kernel.end());
+                auto inserted = stateOf.insert({kernel, kernels.size()});
+                if (inserted.second)  kernels.push_back(kernel);
+                gotos[state].push_back({symbol, inserted.first->second});
+            }
+        }
+    }
+
+    // return the lookaheads of every kernel item, by state, the LALR(1)
+    // way: closing each kernel item over the marker lookahead shows which
+    // lookaheads arise in the items it leads to and which it passes on
+    std::vector<std::vector<SymbolSet>> lalrLookaheads() const {
+        std::vector<std::vector<SymbolSet>> lookaheads(kernels.size());
+        for (size_t state = 0; state < kernels.size(); ++state) {
+            lookaheads[state].assign(kernels[state].size(), SymbolSet(PROPAGATE + 1, false));
+        }
+        // (state, kernel index) -> those it passes its lookaheads to
+        std::map<std::pair<int, int>, std::vector<std::pair<int, int>>> passes;
+        for (size_t state = 0; state < kernels.size(); ++state) {
+            for (size_t k = 0; k < kernels[state].size(); ++k) {
+                SymbolSet marker(PROPAGATE + 1, false);
+                marker[PROPAGATE] = true;
+                for ( const auto &[item, las] : closure({{kernels[state][k], marker}}) ) {
+                    int s = next(item);
+                    if (s < 0)  continue;
+                    int to = target(state, s);
+                    const auto &kernel = kernels[to];
+                    int j = std::lower_bound(kernel.begin(), kernel.end(), item + 1) - kernel.begin();
+                    for (int t = 0; t < PROPAGATE; ++t) {
+                        if (las[t])  lookaheads[to][j][t] = true;
+                    }
+                    if (las[PROPAGATE])  passes[{state, k}].push_back({to, j});
+                }
+            }
+        }
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for ( const auto &[from, tos] : passes ) {
+                const SymbolSet &las = lookaheads[from.first][from.second];
+                for ( const auto &to : tos ) {
+                    SymbolSet &into = lookaheads[to.first][to.second];
+                    for (int t = 0; t < PROPAGATE; ++t) {
+                        if (las[t] && !into[t]) { into[t] = true; changed = true; }
+                    }
+                }
+            }
+        }
+        return lookaheads;
+    }
+
+    // return FOLLOW of every nonterminal, for SLR(1)
+    std::vector<SymbolSet> follow() const {
+        std::vector<SymbolSet> sets(g.numSymbols(), SymbolSet(PROPAGATE + 1, false));
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (size_t r = 0; r < g.numRules(); ++r) {
+                const auto &rhs = g.rhs[r];
+                for (size_t i = 0; i < rhs.size(); ++i) {
+                    if (!g.nonterminal[rhs[i]])  continue;
+                    SymbolSet &into = sets[rhs[i]];
+                    bool rest = true;
+                    for (size_t j = i + 1; rest && j < rhs.size(); ++j) {
+                        for (int t = 0; t < PROPAGATE; ++t) {
+                            if (first[rhs[j]][t] && !into[t]) { into[t] = true; changed = true; }
+                        }
+                        rest = nullable[rhs[j]];
+                    }
+                    if (!rest)  continue;
+                    for (int t = 0; t < PROPAGATE; ++t) {
+                        if (sets[g.lhs[r]][t] && !into[t]) { into[t] = true; changed = true; }
+                    }
+                }
+            }
+        }
+        return sets;
+    }
+
+    // Merge states that no parse can tell apart: those with the same
+    // reductions and transitions on the same symbols to states that are
+    // themselves equivalent, found by refining a partition until it holds
+    void minimize(LRTables &tables) const {
+        size_t n = tables.numStates();
+        std::vector<int> cls(n);
+        size_t classes = 0;
+        for (bool first = true; ; first = false) {
+            std::map<std::vector<int>, int> classOf;
+            std::vector<int> refined(n);
+            for (size_t state = 0; state < n; ++state) {
+                std::vector<int> key;
+                if (first) {
+                    for ( const auto &[la, rule] : tables.reductions[state] ) { key.push_back(la); key.push_back(rule); }
+                    key.push_back(-2);
+                    for ( const auto &[symbol, to] : tables.transitions[state] ) { key.push_back(symbol); }
+                }
+                else {
+                    key.push_back(cls[state]);
+                    for ( const auto &[symbol, to] : tables.transitions[state] ) { key.push_back(cls[to]); }
+                }
+                refined[state] = classOf.insert({key, classOf.size()}).first->second;
+            }
+            cls = refined;
+            if (!first && classOf.size() == classes)  break;
+            classes = classOf.size();
+        }
+        // the classes are numbered by their first state, so state 0 stays 0
+        std::vector<std::vector<std::pair<int, int>>> transitions(classes);
+        std::vector<std::vector<std::pair<int, int>>> reductions(classes);
+        std::vector<bool> done(classes, false);
+        for (size_t state = 0; state < n; ++state) {
+            if (done[cls[state]])  continue;
+            done[cls[state]] = true;
+            for ( const auto &[symbol, to] : tables.transitions[state] ) {
+                transitions[cls[state]].push_back({symbol, cls[to]});
+            }
+            reductions[cls[state]] = tables.reductions[state];
+        }
+        tables.transitions = transitions;
+        tables.reductions = reductions;
+    }
+
+    void findConflicts(LRTables &tables) const {
+        for (size_t state = 0; state < tables.numStates(); ++state) {
+            const auto &shifts = tables.transitions[state];
+            const auto &reductions = tables.reductions[state];
+            std::string where = "state " + std::to_string(state) + " on ";
+            for (size_t i = 0; i < reductions.size(); ++i) {
+                auto [la, rule] = reductions[i];
+                if (la == ACCEPT_LOOKAHEAD)  continue;
+                std::string reduce = "reduce by rule " + std::to_string(rule) + " (" + g.ruleText(rule) + ")";
+                auto shift = std::lower_bound(shifts.begin(), shifts.end(), std::make_pair(la, 0));
+                if (shift != shifts.end() && shift->first == la) {
+                    tables.conflicts.push_back("Shift-reduce conflict in " + where + g.names[la] + ": shift to state " +
+                                               std::to_string(shift->second) + " or " + reduce);
+                }
+                if (i > 0 && reductions[i - 1].first == la) {
+                    int other = reductions[i - 1].second;
+                    tables.conflicts.push_back("Reduce-reduce conflict in " + where + g.names[la] + ": reduce by rule " +
+                                               std::to_string(other) + " (" + g.ruleText(other) + ") or " + reduce);
+                }
+            }
+        }
+    }
+
+  public:
+    explicit LRGenerator(const Grammar &g) : g{g}, PROPAGATE{static_cast<int>(g.numSymbols())} {
+        rulesOf.resize(g.numSymbols());
+        for (size_t r = 0; r < g.numRules(); ++r) {
+            firstItem.push_back(itemRule.size());
+            itemRule.insert(itemRule.end(), g.rhs[r].size() + 1, r);
+            rulesOf[g.lhs[r]].push_back(r);
+        }
+        computeFirst();
+        buildLR0();
+    }
+
+    LRTables generate(const LRMethod method) const {
+        LRTables tables;
+        tables.lr0States = kernels.size();
+        tables.transitions = gotos;
+        tables.reductions.resize(kernels.size());
+        std::vector<std::vector<SymbolSet>> kernelLookaheads;
+        std::vector<SymbolSet> follows;
+        if (method == LRMethod::LALR)  kernelLookaheads = lalrLookaheads();
+        else follows = follow();
+        for (size_t state = 0; state < kernels.size(); ++state) {
+            // complete items and their lookaheads
+            std::vector<std::pair<int, SymbolSet>> complete;
+            if (method == LRMethod::LALR) {
+                std::vector<std::pair<int, SymbolSet>> kernel;
+                for (size_t k = 0; k < kernels[state].size(); ++k) {
+                    kernel.push_back({kernels[state][k], kernelLookaheads[state][k]});
+                }
+                for ( const auto &[item, las] : closure(kernel) ) {
+                    if (next(item) < 0)  complete.push_back({item, las});
+                }
+            }
+            else {
+                for ( int item : closure(kernels[state]) ) {
+                    if (next(item) < 0)  complete.push_back({item, follows[g.lhs[itemRule[item]]]});
+                }
+            }
+            auto &reductions = tables.reductions[state];
+            for ( const auto &[item, las] : complete ) {
+                int rule = itemRule[item];
+                if (rule == 0) {
+                    reductions.push_back({ACCEPT_LOOKAHEAD, 0});
+                    continue;
+                }
+                for (int t = 0; t < PROPAGATE; ++t) {
+                    if (las[t])  reductions.push_back({t, rule});
+                }
+            }
+            std::sort(reductions.begin(), reductions.end());
+        }
+        minimize(tables);
+        findConflicts(tables);
+        return tables;
+    }
+};
+
+inline LRTables generateLR(const Grammar &g, const LRMethod method) {
+    return LRGenerator(g).generate(method);
+}
+
+// Print tables in the format of the .TRANSITIONS and .REDUCTIONS sections
+inline void writeLRTables(Output &out, const Grammar &g, const LRTables &tables) {
+    out << ".TRANSITIONS\n";
+    for (size_t state = 0; state < tables.numStates(); ++state) {
+        for ( const auto &[symbol, to] : tables.transitions[state] ) {
+            out << state << ' ' << g.names[symbol] << ' ' << to << '\n';
+        }
+    }
+    out << ".REDUCTIONS\n";
+    for (size_t state = 0; state < tables.numStates(); ++state) {
+        for ( const auto &[la, rule] : tables.reductions[state] ) {
+            out << state << ' ' << rule << ' ' << (la == ACCEPT_LOOKAHEAD ? LR_ACCEPT : g.names[la]) << '\n';
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef LR_TABLE_H
+#define LR_TABLE_H
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+#include "../Common/dfa-table.h"
+
+//// Compile-time lowering of a grammar and its LR tables into dense arrays.
+// The input is the three sections the parser used to read at startup:
+//   .CFG          one rule "lhs rhs..." per line, rule 0 first; an empty
+//                 right-hand side is written .EMPTY
+//   .TRANSITIONS  one "state symbol state" per line
+//   .REDUCTIONS   one "state rule lookahead" per line; the lookahead
+//                 .ACCEPT marks where rule 0 is reduced at the end of
+//                 the input, which the parser does without a table entry
+// Typical use, with the sections available as constexpr string_views:
+//   constexpr LRSizes sizes = measureLR(cfg, transitions);
+//   constexpr auto lr = compileLR<sizes.symbols, sizes.rules, sizes.rhs,
+//                                 sizes.states>(cfg, transitions, reductions);
+// As with compileDFA, malformed input reaches one of the throws below
+// during constant evaluation, which turns it into a compile error.
+
+constexpr std::string_view LR_EMPTY = ".EMPTY";
+constexpr std::string_view LR_ACCEPT = ".ACCEPT";
+
+// S symbols, R rules, H right-hand side symbols in all and N states
+template <size_t S, size_t R, size_t H, size_t N>
+struct LRTable {
+    static constexpr int16_t NO_ACTION = INT16_MIN;
+    // Symbol IDs are in order of first appearance in the .CFG section
+    std::array<std::string_view, S> names{};
+    std::array<bool, S> nonterminal{};
+    // rule r is lhs[r] -> rhs[rhsStart[r]] ... rhs[rhsStart[r + 1] - 1],
+    // and text[r] is its line in the .CFG section
+    std::array<uint16_t, R> lhs{};
+    std::array<uint16_t, R + 1> rhsStart{};
+    std::array<uint16_t, H> rhs{};
+    std::array<std::string_view, R> text{};
+    // N rows of S entries each. By terminal: a state to shift to,
+    // -(rule + 1) to reduce by rule, or NO_ACTION.
+    std::array<int16_t, N * S> actions{};
+    // by nonterminal: the state to go to, or -1
+    std::array<int16_t, N * S> gotos{};
+
+    constexpr size_t numSymbols() const { return S; }
+    constexpr size_t numRules() const { return R; }
+    constexpr size_t numStates() const { return N; }
+    // return the action on symbol in state; a symbol outside the grammar
+    // has none
+    constexpr int16_t action(const int state, const size_t symbol) const {
+        return symbol < S ? actions[state * S + symbol] : NO_ACTION;
+    }
+    constexpr int16_t go(const int state, const size_t nonterminal) const {
+        return gotos[state * S + nonterminal];
+    }
+    constexpr size_t rhsSize(const size_t rule) const {
+        return rhsStart[rule + 1] - rhsStart[rule];
+    }
+    // return the ID of the symbol with the given name, or S
+    constexpr size_t symbolId(const std::string_view name) const {
+        for (size_t i = 0; i < S; ++i) {
+            if (names[i] == name)  return i;
+        }
+        return S;
+    }
+};
+
+struct LRSizes {
+    size_t symbols;
+    size_t rules;
+    size_t rhs;
+    size_t states;
+};
+
+// Return the text following the header line of a section
+constexpr std::string_view lrSection(std::string_view text, const std::string_view header) {
+    if (dfaNextWord(text) != header) {
+        throw std::logic_error("Expected a section header");
+    }
+    dfaNextLine(text); // rest of the header line
+    return text;
+}
+
+constexpr int lrNumber(const std::string_view word) {
+    if (word.empty())  throw std::logic_error("Expected a number");
+    int n = 0;
+    for (char c : word) {
+        if (c < '0' || c > '9' || n > INT16_MAX)  throw std::logic_error("Expected a number below 32768");
+        n = n * 10 + (c - '0');
+    }
+    return n;
+}
+
+// Whether word occurs in text before position end
+constexpr bool lrSeenBefore(std::string_view text, const std::string_view word, const char *end) {
+    for (std::string_view w = dfaNextWord(text); w.data() < end; w = dfaNextWord(text)) {
+        if (w == word)  return true;
+    }
+    return false;
+}
+
+// Sizes of the grammar in cfg and the tables in transitions, which
+// reach every state
+constexpr LRSizes measureLR(const std::string_view cfg, const std::string_view transitions) {
+    LRSizes sizes{0, 0, 0, 0};
+    const std::string_view rules = lrSection(cfg, ".CFG");
+    std::string_view rest = rules;
+    for (std::string_view word = dfaNextWord(rest); !word.empty(); word = dfaNextWord(rest)) {
+        if (word == LR_EMPTY)  continue;
+        if (!lrSeenBefore(rules, word, word.data()))  ++sizes.symbols;
+    }
+    rest = rules;
+    while (!rest.empty()) {
+        std::string_view line = dfaNextLine(rest);
+        if (dfaNextWord(line).empty())  continue;
+        ++sizes.rules;
+        for (std::string_view word = dfaNextWord(line); !word.empty(); word = dfaNextWord(line)) {
+            if (word != LR_EMPTY)  ++sizes.rhs;
+        }
+    }
+    rest = lrSection(transitions, ".TRANSITIONS");
+    while (!rest.empty()) {
+        std::string_view line = dfaNextLine(rest);
+        std::string_view from = dfaNextWord(line);
+        if (from.empty())  continue;
+        dfaNextWord(line);
+        int to = lrNumber(dfaNextWord(line));
+        int most = lrNumber(from) > to ? lrNumber(from) : to;
+        if (static_cast<size_t>(most) >= sizes.states)  sizes.states = most + 1;
+    }
+    return sizes;
+}
+
+template <size_t S, size_t R, size_t H, size_t N>
+constexpr LRTable<S, R, H, N> compileLR(const std::string_view cfg, const std::string_view transitions,
+                                        const std::string_view reductions) {
+    static_assert(N <= INT16_MAX && R <= INT16_MAX && S < UINT16_MAX, "Grammar too large for the LR tables");
+    LRTable<S, R, H, N> lr{};
+
+    // Store symbols and rules
+    const std::string_view rules = lrSection(cfg, ".CFG");
+    size_t symbols = 0;
+    std::string_view rest = rules;
+    for (std::string_view word = dfaNextWord(rest); !word.empty(); word = dfaNextWord(rest)) {
+        if (word != LR_EMPTY && lr.symbolId(word) == S)  lr.names[symbols++] = word;
+    }
+    size_t rule = 0;
+    size_t rhs = 0;
+    rest = rules;
+    while (!rest.empty()) {
+        std::string_view line = dfaNextLine(rest);
+        std::string_view words = line;
+        std::string_view lhs = dfaNextWord(words);
+        if (lhs.empty())  continue;
+        if (lhs == LR_EMPTY)  throw std::logic_error("Rule without a left-hand side");
+        // Nodes of the parse tree are named by this text, so it must be
+        // in the form the parser prints: symbols separated by one space
+        while (dfaIsSpace(line.back()))  line.remove_suffix(1);
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (dfaIsSpace(line[i]) && (line[i] != ' ' || dfaIsSpace(line[i + 1]))) {
+                throw std::logic_error("Rule symbols must be separated by single spaces");
+            }
+        }
+        lr.lhs[rule] = lr.symbolId(lhs);
+        lr.nonterminal[lr.lhs[rule]] = true;
+        lr.text[rule] = line;
+        lr.rhsStart[rule] = rhs;
+        for (std::string_view word = dfaNextWord(words); !word.empty(); word = dfaNextWord(words)) {
+            if (word == LR_EMPTY) {
+                if (rhs != lr.rhsStart[rule] || !dfaNextWord(words).empty()) {
+                    throw std::logic_error(".EMPTY must be the whole right-hand side");
+                }
+                break;
+            }
+            lr.rhs[rhs++] = lr.symbolId(word);
+        }
+        ++rule;
+    }
+    lr.rhsStart[rule] = rhs;
+
+    // Store transitions; one on a nonterminal is a goto, any other a shift
+    for (size_t i = 0; i < lr.actions.size(); ++i) {
+        lr.actions[i] = lr.NO_ACTION;
+        lr.gotos[i] = -1;
+    }
+    rest = lrSection(transitions, ".TRANSITIONS");
+    while (!rest.empty()) {
+        std::string_view line = dfaNextLine(rest);
+        std::string_view from = dfaNextWord(line);
+        if (from.empty())  continue;
+        size_t symbol = lr.symbolId(dfaNextWord(line));
+        int to = lrNumber(dfaNextWord(line));
+        if (symbol == S)  throw std::logic_error("Transition on a symbol outside the grammar");
+        if (!dfaNextWord(line).empty())  throw std::logic_error("Extra words in transition line");
+        size_t cell = lrNumber(from) * S + symbol;
+        if (lr.nonterminal[symbol])  lr.gotos[cell] = to;
+        else lr.actions[cell] = to;
+    }
+
+    // Store reductions; where a state also shifts on the lookahead, the
+    // reduction wins
+    rest = lrSection(reductions, ".REDUCTIONS");
+    while (!rest.empty()) {
+        std::string_view line = dfaNextLine(rest);
+        std::string_view state = dfaNextWord(line);
+        if (state.empty())  continue;
+        int by = lrNumber(dfaNextWord(line));
+        std::string_view lookaheadName = dfaNextWord(line);
+        if (lookaheadName == LR_ACCEPT)  continue;
+        size_t lookahead = lr.symbolId(lookaheadName);
+        if (lrNumber(state) >= static_cast<int>(N))  throw std::logic_error("Reduction in a state without transitions");
+        if (by >= static_cast<int>(R))  throw std::logic_error("Reduction by an unknown rule");
+        if (lookahead == S || lr.nonterminal[lookahead]) {
+            throw std::logic_error("Reduction on a lookahead that is not a terminal");
+        }
+        int16_t &entry = lr.actions[lrNumber(state) * S + lookahead];
+        if (entry < 0 && entry != lr.NO_ACTION)  throw std::logic_error("Reduce-reduce conflict in the tables");
+        entry = -(by + 1);
+    }
+    return lr;
+}
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef WLP4PARSE_H
+#define WLP4PARSE_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "wlp4data.h"
+#include "lr-table.h"
+#include "../Common/output.h"
+#include "../Common/symbol-table.h"
+
+// The parsing core of wlp4parse: the grammar, the LR tables, the token
+// and tree types and the parsing loop. wlp4parse-prescanned.cc adds the
+// command line and the token readers.
+
+// The grammar and its tables, lowered into dense arrays at build time
+constexpr LRSizes WLP4_SIZES = measureLR(WLP4_CFG, WLP4_TRANSITIONS);
+constexpr auto WLP4_LR = compileLR<WLP4_SIZES.symbols, WLP4_SIZES.rules, WLP4_SIZES.rhs,
+                                   WLP4_SIZES.states>(WLP4_CFG, WLP4_TRANSITIONS, WLP4_REDUCTIONS);
+
+// Token kinds and lexemes are interned here, so the parser compares and
+// looks up integers instead of strings. The grammar symbols are interned
+// first, so their symbols are their IDs in WLP4_LR.
+inline SymbolTable symbols = [] {
+    SymbolTable grammar;
+    for ( const auto &name : WLP4_LR.names ) { grammar.intern(name); }
+    return grammar;
+}();
+
+// A token as the parser reads it, kind and lexeme interned; named apart
+// from the scanners' Token so both headers can be included together
+struct ParseToken {
+    Symbol kind;
+    Symbol lexeme;
+    ParseToken(Symbol kind, Symbol lexeme) : kind{kind}, lexeme{lexeme} {}
+    ParseToken(std::string_view kind, std::string_view lexeme) :
+        kind{symbols.intern(kind)}, lexeme{symbols.intern(lexeme)} {}
+};
+
+// The parse tree as parallel arrays with one entry per node, in the
+// post-order the parser builds it in: the children of a node come before
+// it, and the root is last. The children of each node are contiguous in
+// children, in order, so a tree is walked by index alone.
+struct ParseTree {
+    static constexpr int16_t LEAF = -1;
+    // by node: its rule, or LEAF for a token
+    std::vector<int16_t> rules;
+    // by node: where its children start in children, and how many
+    std::vector<uint32_t> firstChild;
+    std::vector<uint16_t> numChildren;
+    // by node: the index of a leaf's token in the parsed tokens
+    std::vector<uint32_t> tokens;
+    std::vector<uint32_t> children;
+
+    size_t size() const { return rules.size(); }
+    uint32_t root() const { return size() - 1; }
+    bool isLeaf(const uint32_t node) const { return rules[node] == LEAF; }
+    uint32_t child(const uint32_t node, const size_t i) const { return children[firstChild[node] + i]; }
+
+    void reserve(const size_t nodes) {
+        rules.reserve(nodes);
+        firstChild.reserve(nodes);
+        numChildren.reserve(nodes);
+        tokens.reserve(nodes);
+        children.reserve(nodes);
+    }
+
+    // return the index of a new leaf for token
+    uint32_t addLeaf(const uint32_t token) {
+        rules.push_back(LEAF);
+        firstChild.push_back(children.size());
+        numChildren.push_back(0);
+        tokens.push_back(token);
+        return size() - 1;
+    }
+
+    // return the index of a new node for rule over the given children
+    uint32_t addNode(const int16_t rule, const uint32_t *first, const size_t count) {
+        rules.push_back(rule);
+        firstChild.push_back(children.size());
+        numChildren.push_back(count);
+        tokens.push_back(0);
+        children.insert(children.end(), first, first + count);
+        return size() - 1;
+    }
+
+    // Print the tree in pre-order, a node's rule or "kind lexeme" per line
+    void print(Output &out, const std::vector<ParseToken> &parsed) const {
+        std::vector<uint32_t> pending{root()};
+        while (!pending.empty()) {
+            uint32_t node = pending.back();
+            pending.pop_back();
+            if (isLeaf(node)) {
+                const ParseToken &tk = parsed[tokens[node]];
+                out << symbols.name(tk.kind) << ' ' << symbols.name(tk.lexeme) << '\n';
+                continue;
+            }
+            out << WLP4_LR.text[rules[node]] << '\n';
+            for (size_t i = numChildren[node]; i > 0; --i) { pending.push_back(child(node, i - 1)); }
+        }
+    }
+};
+
+// Read "kind lexeme" token lines from input into tokens, between BOF
+// and EOF. As with >> on each line, a missing word keeps the value it
+// had on the line before.
+inline void readTokens(std::string_view input, std::vector<ParseToken> &tokens) {
+    std::string_view kind = "BOF";
+    std::string_view lexeme = "BOF";
+    // Add BOF BOF
+    tokens.push_back(ParseToken(kind, lexeme));
+    auto isSpace = [](char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    };
+    while (!input.empty()) {
+        size_t newline = input.find('\n');
+        std::string_view line = input.substr(0, newline);
+        input.remove_prefix(newline == std::string_view::npos ? input.size() : newline + 1);
+        std::string_view *words[] = {&kind, &lexeme};
+        for ( auto word : words ) {
+            size_t i = 0;
+            while (i < line.size() && isSpace(line[i]))  ++i;
+            size_t j = i;
+            while (j < line.size() && !isSpace(line[j]))  ++j;
+            if (j == i)  break;
+            *word = line.substr(i, j - i);
+            line.remove_prefix(j);
+        }
+        tokens.push_back(ParseToken(kind, lexeme));
+    }
+    // Add EOF EOF
+    tokens.push_back(ParseToken("EOF", "EOF"));
+}
+
+// according to the rule, pop the rhs trees and then
+// push the new lhs tree to the treeStack
+inline void reduceTrees(const size_t rule, std::vector<uint32_t> &treeStack, ParseTree &tree) {
+    size_t len = WLP4_LR.rhsSize(rule);
+    uint32_t node = tree.addNode(rule, treeStack.data() + treeStack.size() - len, len);
+    treeStack.resize(treeStack.size() - len);
+    treeStack.push_back(node);
+}
+
+// Parse tokens, which run from BOF to EOF, into tree
+inline void parse(const std::vector<ParseToken> &tokens, ParseTree &tree) {
+    std::vector<int> stateStack;
+    std::vector<uint32_t> treeStack;
+    stateStack.push_back(0);
+    // a node per token and at most about one per reduction
+    tree.reserve(2 * tokens.size());
+
+    // parsing loop
+    for (size_t t = 0; t < tokens.size(); ++t) {
+        const ParseToken &tk = tokens[t];
+        int action = WLP4_LR.action(stateStack.back(), tk.kind);
+        while (action < 0 && action != WLP4_LR.NO_ACTION) {
+            // reduce: pop the states of the rule's rhs and go to the
+            // state for its lhs
+            size_t rule = -action - 1;
+            reduceTrees(rule, treeStack, tree);
+            stateStack.resize(stateStack.size() - WLP4_LR.rhsSize(rule));
+            int newState = WLP4_LR.go(stateStack.back(), WLP4_LR.lhs[rule]);
+            if (newState < 0) {
+                throw std::runtime_error("Can not find the transition!");
+            }
+            stateStack.push_back(newState);
+            action = WLP4_LR.action(stateStack.back(), tk.kind);
+        }
+        // shift
+        treeStack.push_back(tree.addLeaf(t));
+        if (action == WLP4_LR.NO_ACTION) {
+            throw std::runtime_error("Can not find the transition!");
+        }
+        stateStack.push_back(action);
+    }
+    // obtain the final tree
+    reduceTrees(0, treeStack, tree);
+
+    if (treeStack.size() != 1) {
+        throw std::runtime_error("idk what happened");
+    }
+}
+
+#endif
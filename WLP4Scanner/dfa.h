@@ -1,7 +1,86 @@
 #ifndef DFA_H
 #define DFA_H
 
-#include <string>
-extern std::string DFAstring;
+#include <string_view>
+// The WLP4 scanning DFA as a DFA file. The scanner compiles it into a
+// transition table at build time, see Common/dfa-table.h.
+// Keywords are scanned as ID and reclassified by the scanner, so the
+// keyword states (INT, WAIN, ...) have no transitions and only name
+// their token kinds.
+namespace wlp4 {
+
+constexpr std::string_view DFAstring = R"(
+.STATES
+start
+ID!
+NUM!
+INT!
+WAIN!
+IF!
+ELSE!
+WHILE!
+PRINTLN!
+RETURN!
+NEW!
+DELETE!
+NULL!
+LPAREN!
+RPAREN!
+LBRACE!
+RBRACE!
+LBRACK!
+RBRACK!
+BECOMES!
+PLUS!
+MINUS!
+STAR!
+SLASH!
+PCT!
+AMP!
+COMMA!
+SEMI!
+LT!
+GT!
+LE!
+GE!
+EQ!
+NE!
+?WHITESPACE!
+?COMMENT!
+exclamation
+.TRANSITIONS
+start 0-9 NUM
+NUM 0-9 NUM
+start a-z A-Z ID
+ID a-z A-Z 0-9 ID
+start ( LPAREN
+start ) RPAREN
+start { LBRACE
+start } RBRACE
+start [ LBRACK
+start ] RBRACK
+start = BECOMES
+start + PLUS
+start - MINUS
+start * STAR
+start / SLASH
+start % PCT
+start & AMP
+start , COMMA
+start ; SEMI
+start < LT
+start > GT
+LT = LE
+GT = GE
+BECOMES = EQ
+start ! exclamation
+exclamation = NE
+start \x20 \x09 \x0a \x0d ?WHITESPACE
+?WHITESPACE \x20 \x09 \x0a \x0d ?WHITESPACE
+SLASH / ?COMMENT
+?COMMENT \x00-\x09 \x0B \x0C \x0E-\x7F ?COMMENT
+)";
+
+}
 
 #endif
@@ -0,0 +1,240 @@
+#ifndef WLP4SCAN_H
+#define WLP4SCAN_H
+
+#include <string_view>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+//// The dfa.h header defines a string constant containing a DFA file:
+// constexpr std::string_view wlp4::DFAstring = ...
+#include "dfa.h"
+#include "../Common/dfa-table.h"
+#include "../Common/simd-skip.h"
+#include "../Common/numparse.h"
+#include "../Common/parallel.h"
+#include "../Common/scanner.h"
+
+// The scanning core of wlp4scan: the DFA, the token type and smm.
+// wlp4scan.cc adds the command line and the output formats. Everything
+// is in namespace wlp4, so the MIPS scanner can be used alongside it.
+
+namespace wlp4 {
+
+// The scanning DFA, compiled from DFAstring at build time
+constexpr auto SCAN_DFA = compileDFA<countDFAStates(DFAstring)>(DFAstring);
+
+// return the state ID naming a token kind; unknown kinds fail the build
+constexpr uint16_t kindId (const std::string_view name) {
+    uint16_t id = SCAN_DFA.stateId(name);
+    if (id == NO_STATE)  throw std::logic_error ("DFA does not declare this token kind");
+    return id;
+}
+
+constexpr uint16_t ID_STATE = kindId("ID");
+constexpr uint16_t NUM_STATE = kindId("NUM");
+constexpr uint16_t WHITESPACE_STATE = kindId("?WHITESPACE");
+constexpr uint16_t COMMENT_STATE = kindId("?COMMENT");
+
+// WLP4Spec skips whitespace and comment runs with skipAnyOf and
+// skipComment, which must consume exactly what the DFA would
+static_assert(SCAN_DFA.selfLoopsOn(WHITESPACE_STATE, [](int c) {
+                  return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }) &&
+              SCAN_DFA.selfLoopsOn(COMMENT_STATE, [](int c) {
+                  return c != '\n' && c != '\r'; }),
+              "fast skips do not match the whitespace and comment states");
+
+struct Keyword {
+    std::string_view spelling;
+    uint16_t kind;
+};
+
+// The DFA scans keywords as ID; keywordKind picks them out again
+constexpr Keyword KEYWORDS[] = {
+    {"if", kindId("IF")},
+    {"int", kindId("INT")},
+    {"wain", kindId("WAIN")},
+    {"while", kindId("WHILE")},
+    {"else", kindId("ELSE")},
+    {"println", kindId("PRINTLN")},
+    {"return", kindId("RETURN")},
+    {"new", kindId("NEW")},
+    {"delete", kindId("DELETE")},
+    {"NULL", kindId("NULL")},
+};
+
+// return the token kind of an ID lexeme: its keyword kind, or ID_STATE.
+// The first character and the length select the only keyword the lexeme
+// could be, so at most one comparison is made.
+constexpr uint16_t keywordKind (const std::string_view lexeme) {
+    int candidate = 0;
+    switch (lexeme[0]) {
+        case 'i': candidate = lexeme.size() == 2 ? 0 : 1; break;
+        case 'w': candidate = lexeme.size() == 4 ? 2 : 3; break;
+        case 'e': candidate = 4; break;
+        case 'p': candidate = 5; break;
+        case 'r': candidate = 6; break;
+        case 'n': candidate = 7; break;
+        case 'd': candidate = 8; break;
+        case 'N': candidate = 9; break;
+        default: return ID_STATE;
+    }
+    if (lexeme == KEYWORDS[candidate].spelling)  return KEYWORDS[candidate].kind;
+    return ID_STATE;
+}
+
+constexpr bool allKeywordsRecognised () {
+    for ( const Keyword &k : KEYWORDS ) {
+        if (keywordKind(k.spelling) != k.kind)  return false;
+    }
+    return true;
+}
+static_assert(allKeywordsRecognised(), "keywordKind does not match KEYWORDS");
+
+// A token is a slice of the input buffer together with the DFA state
+// that accepted it, so scanning never copies a lexeme
+struct Token {
+    uint16_t kind;
+    uint32_t length;
+    size_t offset;
+    Token (uint16_t kind, size_t offset, uint32_t length) :
+        kind{kind}, length{length}, offset{offset} {}
+    std::string_view lexeme (const std::string_view input) const {
+        return input.substr(offset, length);
+    }
+};
+
+// Inputs smaller than this are not worth splitting across threads
+const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+// The WLP4 language for Scanner: NUM values are range-checked and
+// keywords, which the DFA scans as ID, get their own kinds
+struct WLP4Spec {
+    typedef wlp4::Token Token;
+    static constexpr const auto &DFA = SCAN_DFA;
+    static constexpr uint16_t WHITESPACE_STATE = wlp4::WHITESPACE_STATE;
+    static constexpr uint16_t COMMENT_STATE = wlp4::COMMENT_STATE;
+
+    static const char *whitespaceEnd(const char *p, const char *end) {
+        return skipAnyOf(p, end, ' ', '\t', '\n', '\r');
+    }
+    static const char *commentEnd(const char *p, const char *end) {
+        return skipComment(p, end);
+    }
+
+    static Token makeToken(const uint16_t state, const std::string_view lexeme, const size_t offset) {
+        if (state == NUM_STATE) {
+            int32_t value;
+            if (!parseWLP4Num(lexeme, value)) {
+                throw std::runtime_error ("NUM value is not valid");
+            }
+        }
+        uint16_t kind = state == ID_STATE ? keywordKind(lexeme) : state;
+        return Token(kind, offset, lexeme.size());
+    }
+};
+
+// return the tokens of input[begin, input.size()); token offsets are
+// relative to the start of input
+inline std::vector<Token> smm(const std::string_view input, const size_t begin) {
+    return Scanner<WLP4Spec>::smm(input, begin);
+}
+
+// Scan input in chunks on up to jobs threads, with the same result as
+// smm(input, 0). Chunks end right after a newline. A newline can only be
+// part of a whitespace token (WLP4 has only line comments, which stop
+// before it), so every cut either falls between tokens or splits a
+// skipped whitespace run. If scanning fails, the error of the earliest
+// failing chunk is the one smm would have reported.
+inline std::vector<Token> parallelSmm(const std::string_view input, const unsigned jobs) {
+    std::vector<size_t> cuts{0};
+    size_t numChunks = std::min<size_t>(jobs, input.size() / MIN_CHUNK_SIZE + 1);
+    for (size_t k = 1; k < numChunks; ++k) {
+        size_t target = std::max(cuts.back(), input.size() / numChunks * k);
+        const void *newline = memchr(input.data() + target, '\n', input.size() - target);
+        if (!newline)  break;
+        cuts.push_back(static_cast<const char *>(newline) - input.data() + 1);
+    }
+    cuts.push_back(input.size());
+
+    std::vector<std::vector<Token>> chunks(cuts.size() - 1);
+    parallelFor(chunks.size(), jobs, [&](size_t k) {
+        chunks[k] = smm(input.substr(0, cuts[k + 1]), cuts[k]);
+    });
+
+    size_t total = 0;
+    for ( const auto &c : chunks ) { total += c.size(); }
+    std::vector<Token> tokenLexemes;
+    tokenLexemes.reserve(total);
+    for ( const auto &c : chunks ) {
+        tokenLexemes.insert(tokenLexemes.end(), c.begin(), c.end());
+    }
+    return tokenLexemes;
+}
+
+// The tokens a rescan replaced: tokens [first, first + removed) of the
+// old array became tokens [first, first + inserted) of the new one
+struct TokenSplice {
+    size_t first;
+    size_t removed;
+    size_t inserted;
+};
+
+// Bring tokens, the result of smm(old, 0), up to date after the bytes
+// [editStart, editStart + removed) of old were replaced by inserted new
+// bytes, giving input. Only the edited region is scanned again:
+//  - Scanning restarts at the end of the last token that ends before
+//    editStart. The character after that token is unchanged, so the
+//    token and everything before it are too.
+//  - It stops at the first new token that starts at or after the end of
+//    the inserted bytes, at the same place in the unchanged text as an old
+//    token. From there on the input is the same, so the old tokens are,
+//    shifted by the change in length.
+// If the edited input does not scan, tokens is left as it was.
+inline TokenSplice rescan(std::vector<Token> &tokens, const std::string_view input,
+                          const size_t editStart, const size_t removed, const size_t inserted) {
+    const size_t editEnd = editStart + inserted;
+    auto restart = std::partition_point(tokens.begin(), tokens.end(), [&](const Token &t) {
+        return t.offset + t.length < editStart;
+    });
+    size_t first = restart - tokens.begin();
+    size_t begin = first ? tokens[first - 1].offset + tokens[first - 1].length : 0;
+
+    // old tokens that lie past the edit sit `removed - inserted` further on
+    std::vector<Token> fresh;
+    size_t resync = first;
+    bool synced = false;
+    Scanner<WLP4Spec>::scan(input, begin, [&](const Token &t) {
+        if (t.offset >= editEnd) {
+            size_t oldOffset = t.offset - inserted + removed;
+            while (resync < tokens.size() && tokens[resync].offset < oldOffset)  ++resync;
+            if (resync < tokens.size() && tokens[resync].offset == oldOffset) {
+                synced = true;
+                return false;
+            }
+        }
+        fresh.push_back(t);
+        return true;
+    });
+    if (!synced)  resync = tokens.size();
+
+    for (size_t k = resync; k < tokens.size(); ++k) {
+        tokens[k].offset = tokens[k].offset - removed + inserted;
+    }
+    size_t dropped = resync - first;
+    if (fresh.size() <= dropped) {
+        std::copy(fresh.begin(), fresh.end(), tokens.begin() + first);
+        tokens.erase(tokens.begin() + first + fresh.size(), tokens.begin() + resync);
+    }
+    else {
+        std::copy(fresh.begin(), fresh.begin() + dropped, tokens.begin() + first);
+        tokens.insert(tokens.begin() + resync, fresh.begin() + dropped, fresh.end());
+    }
+    return {first, dropped, fresh.size()};
+}
+
+}
+
+#endif
@@ -3,12 +3,13 @@
 #include <sstream>
 #include <iostream>
 #include <map>
+#include "../Common/output.h"
 using namespace std;
 
 const string EMPTY = ".EMPTY";
 
 enum class TypeVariable { INT, PINT, NOTYPE };
-ostream &operator<<(ostream &out, const TypeVariable &tv) {
+Output &operator<<(Output &out, const TypeVariable &tv) {
     switch (tv) {
         case (TypeVariable::INT):
             out << ": INT";
@@ -49,8 +50,8 @@ struct Node {
         }
     }
     void print() {
-        cout << rule << kind << ' ' << lexeme
-             << type << endl;
+        out << rule << kind << ' ' << lexeme
+            << type << '\n';
         for ( auto &n : children ) { n->print(); }
     }
     ~Node() {
@@ -311,12 +312,18 @@ void collectProcedures(Node *tree, ProcedureTable &p) {
 }
 
 int main() {
+    ios::sync_with_stdio(false);
     Node *parseTree = new Node(cin);
     try {
         ProcedureTable ptable;
         collectProcedures(parseTree->children[1], ptable);
         checkOtherRequirements(parseTree->children[1]);
         parseTree->print();
+        out.flush();
+    } catch (OutputError &e) {
+        cerr << "ERROR: " << e.what() << endl;
+        delete parseTree;
+        return 1;
     } catch (runtime_error &e) {
         cerr << "ERROR: " << e.what() << endl;
     }